@@ -17,25 +17,33 @@ if [ ! -d $MONO_NX_ROOT ]; then
     exit 1
 fi
 
+# MONO_NX_CONFIG=Release builds the optimized runtime, select it with MONO_NX_CONFIG=Release in the native makefiles, see notes/release_build.md
+MONO_NX_CONFIG=${MONO_NX_CONFIG:-Debug}
+
 pushd $MONO_NX_ROOT
 
-echo building mono interpreter
+echo building mono interpreter \($MONO_NX_CONFIG\)
 
 export ROOTFS_DIR=$DEVKITPRO
-./build.sh --subset mono.runtime+mono.corelib+libs.native+libs.sfx --cross -a arm64 --os libnx
+./build.sh --subset mono.runtime+mono.corelib+libs.native+libs.sfx --cross -a arm64 --os libnx -c $MONO_NX_CONFIG
 
 # Example: build just the Crypto library. Note that this requires an absolute path.
 # ./build.sh --cross -a arm64 --os libnx --projects $MONO_NX_ROOT/src/libraries/System.Security.Cryptography/System.Security.Cryptography.sln
 
 echo building target AOT offsets
 
-./build.sh -s mono.aotcross /p:MonoGenerateOffsetsOSGroups=libnx
+./build.sh -s mono.aotcross -c $MONO_NX_CONFIG /p:MonoGenerateOffsetsOSGroups=libnx
 
 echo building host AOT cross-compiler
 
 # Force the build system to use the host toolchain
 export ROOTFS_DIR=
-./build.sh -s mono /p:AotHostArchitecture=x64 /p:AotHostOS=linux /p:MonoCrossAOTTargetOS=libnx /p:SkipMonoCrossJitConfigure=true /p:BuildMonoAOTCrossCompilerOnly=true /p:BuildMonoAOTCrossCompiler=true
+# MONO_NX_LLVM=1 builds the cross compiler with the LLVM backend, needed for AOT_BACKEND=llvm in native/aot
+if [ "$MONO_NX_LLVM" = "1" ]; then
+    CROSS_LLVM_FLAGS="/p:MonoAOTEnableLLVM=true"
+fi
+
+./build.sh -s mono -c $MONO_NX_CONFIG /p:AotHostArchitecture=x64 /p:AotHostOS=linux /p:MonoCrossAOTTargetOS=libnx /p:SkipMonoCrossJitConfigure=true /p:BuildMonoAOTCrossCompilerOnly=true /p:BuildMonoAOTCrossCompiler=true $CROSS_LLVM_FLAGS
 
 # If everything went well, copy the output libraries to the sd output folder
 popd
\ No newline at end of file
@@ -2,6 +2,14 @@
 
 set -e 
 
+# MONO_NX_CONFIG=Release copies the Release runtime and the nro files built with make MONO_NX_CONFIG=Release,
+# the dlls on the sd card must come from the same mono build as the nro, see notes/release_build.md
+MONO_NX_CONFIG=${MONO_NX_CONFIG:-Debug}
+FLAVOR=
+if [ "$MONO_NX_CONFIG" = "Release" ]; then
+    FLAVOR=_release
+fi
+
 # Copy the icu data file to the sd card files
 mkdir -p sd_files/mono/etc/
 cp $ICU_NX_INSTALL_DIR/share/icu/77.1/icudt77l.dat  sd_files/mono/etc/
@@ -9,17 +17,19 @@ cp $ICU_NX_INSTALL_DIR/share/icu/77.1/icudt77l.dat  sd_files/mono/etc/
 # Copy the dotnet runtime dlls
 mkdir -p sd_files/mono/lib_net9.0
 mkdir -p sd_files/mono/framework_net9.0
-cp $MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.Debug/*.dll sd_files/mono/lib_net9.0/
-cp $MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-Debug-arm64/*.dll sd_files/mono/framework_net9.0/
+cp $MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.$MONO_NX_CONFIG/*.dll sd_files/mono/lib_net9.0/
+cp $MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-$MONO_NX_CONFIG-arm64/*.dll sd_files/mono/framework_net9.0/
 
 # Copy mono and the fallback dll
-cp native/interpreter/mono_nx.nro sd_files/mono/
+cp native/interpreter/mono_nx$FLAVOR.nro sd_files/mono/mono_nx.nro
 cp managed/pad_input/bin/Debug/net9.0/pad_input.dll sd_files/mono/
+cp managed/launcher/bin/Debug/net9.0/launcher.dll sd_files/mono/
 
 # Copy the managed binaries to the switch folder
 mkdir -p sd_files/switch/
 cp managed/pad_input/bin/Debug/net9.0/pad_input.dll sd_files/switch/
 cp managed/example/bin/Debug/net9.0/example.dll sd_files/switch/
+cp managed/benchmark/bin/Debug/net9.0/benchmark.dll sd_files/switch/
 
 # We commit this binary file in the repo cause there is no way to build it on linux but it's one of the demos that can be run by mono-nx
 cp native/aot/managed/guess_number.exe sd_files/switch/
@@ -28,9 +38,25 @@ mkdir -p sd_files/switch/explorer_demo/
 cp managed/explorer_demo/bin/Debug/net9.0/explorer_demo.dll sd_files/switch/explorer_demo/
 cp managed/explorer_demo/bin/Debug/net9.0/OpenSans-Regular.ttf sd_files/switch/explorer_demo/
 
+# Copy the bundles if they have been packed with MONO_NX_PACK=1 ./managed_build.sh, explorer_demo needs its font next to it
+if [ -d managed/bundles ]; then
+    for bundle in managed/bundles/*.bundle; do
+        if [ "$(basename $bundle)" = "explorer_demo.bundle" ]; then
+            cp $bundle sd_files/switch/explorer_demo/
+        else
+            cp $bundle sd_files/switch/
+        fi
+    done
+fi
+
+# Copy the mixed mode interpreter if it has been built
+if [ -f native/interpreter/mono_nx_mixed$FLAVOR.nro ]; then
+    cp native/interpreter/mono_nx_mixed$FLAVOR.nro sd_files/mono/mono_nx_mixed.nro
+fi
+
 # Copy the aot demo if it has been built
-if [ -f native/aot/aot_example.nro ]; then
-    cp native/aot/aot_example.nro sd_files/switch/
+if [ -f native/aot/aot_example$FLAVOR.nro ]; then
+    cp native/aot/aot_example$FLAVOR.nro sd_files/switch/aot_example.nro
 fi
 
 # Prepare the release
@@ -97,14 +97,9 @@ ICU_INCLUDE_DIR="$ICU_NX_INSTALL_DIR/include"
 ICU_LIB_DIR="$ICU_NX_INSTALL_DIR/lib"
 ICU_DATA_FILE="$ICU_NX_INSTALL_DIR/share/icu/77.1/icudt77l.dat"
 
-MONO_DLL_DIR="$MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.Debug"
-MONO_INCLUDE_DIR="$MONO_DLL_DIR/include/mono-2.0"
-RUNTIME_DLL_DIR="$MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-Debug-arm64"
-NATIVE_LIB_DIR="$MONO_NX_ROOT/artifacts/bin/native/net9.0-libnx-Debug-arm64"
-MONO_LIB_DIR="$MONO_NX_ROOT/artifacts/obj/mono/libnx.arm64.Debug/out/lib"
-ZLIB_DIR="$MONO_NX_ROOT/artifacts/obj/mono/libnx.arm64.Debug/_deps/fetchzlibng-build"
-LINKER_DIR="$MONO_NX_ROOT/artifacts/bin/Mono.Linker/Debug/net9.0"
-AOT_CROSS_DIR="$MONO_NX_ROOT/artifacts/bin/mono/linux.x64.Debug/cross/linux-x64/libnx-arm64"
+# Both mono flavours are packaged so the makefiles can pick one with MONO_NX_CONFIG, override this to package only one of them
+MONO_NX_SDK_CONFIGS="${MONO_NX_SDK_CONFIGS:-Debug Release}"
+
 ILLINK_DIR="$MONO_NX_ROOT/src/mono/System.Private.CoreLib/src/ILLink"
 
 ILLINK_FILES=(
@@ -123,15 +118,30 @@ copy_static_libs "$ICU_LIB_DIR" "$SDK_STAGE/icu/libnx/lib"
 
 copy_file "$ICU_DATA_FILE" "$SDK_STAGE/icu/libnx/share/icu/77.1/icudt77l.dat"
 
-echo "Collecting Mono runtime payload..."
-copy_dir "$MONO_INCLUDE_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/bin/mono/libnx.arm64.Debug/include/mono-2.0"
-copy_dlls "$MONO_DLL_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/bin/mono/libnx.arm64.Debug"
-copy_dlls "$RUNTIME_DLL_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/bin/runtime/net9.0-libnx-Debug-arm64"
-copy_dir "$LINKER_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/bin/Mono.Linker/Debug/net9.0"
-copy_dir "$AOT_CROSS_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/bin/mono/linux.x64.Debug/cross/linux-x64/libnx-arm64"
-copy_static_libs "$NATIVE_LIB_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/bin/native/net9.0-libnx-Debug-arm64"
-copy_static_libs "$MONO_LIB_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/obj/mono/libnx.arm64.Debug/out/lib"
-copy_static_libs "$ZLIB_DIR" "$SDK_STAGE/dotnet_runtime/artifacts/obj/mono/libnx.arm64.Debug/_deps/fetchzlibng-build"
+collect_mono() {
+    local config="$1"
+    local mono_dll_dir="$MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.$config"
+    local runtime_dll_dir="$MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-$config-arm64"
+    local native_lib_dir="$MONO_NX_ROOT/artifacts/bin/native/net9.0-libnx-$config-arm64"
+    local mono_obj_dir="$MONO_NX_ROOT/artifacts/obj/mono/libnx.arm64.$config"
+    local linker_dir="$MONO_NX_ROOT/artifacts/bin/Mono.Linker/$config/net9.0"
+    local aot_cross_dir="$MONO_NX_ROOT/artifacts/bin/mono/linux.x64.$config/cross/linux-x64/libnx-arm64"
+    local dest="$SDK_STAGE/dotnet_runtime/artifacts"
+
+    echo "Collecting Mono runtime payload ($config)..."
+    copy_dir "$mono_dll_dir/include/mono-2.0" "$dest/bin/mono/libnx.arm64.$config/include/mono-2.0"
+    copy_dlls "$mono_dll_dir" "$dest/bin/mono/libnx.arm64.$config"
+    copy_dlls "$runtime_dll_dir" "$dest/bin/runtime/net9.0-libnx-$config-arm64"
+    copy_dir "$linker_dir" "$dest/bin/Mono.Linker/$config/net9.0"
+    copy_dir "$aot_cross_dir" "$dest/bin/mono/linux.x64.$config/cross/linux-x64/libnx-arm64"
+    copy_static_libs "$native_lib_dir" "$dest/bin/native/net9.0-libnx-$config-arm64"
+    copy_static_libs "$mono_obj_dir/out/lib" "$dest/obj/mono/libnx.arm64.$config/out/lib"
+    copy_static_libs "$mono_obj_dir/_deps/fetchzlibng-build" "$dest/obj/mono/libnx.arm64.$config/_deps/fetchzlibng-build"
+}
+
+for config in $MONO_NX_SDK_CONFIGS; do
+    collect_mono "$config"
+done
 
 echo "Collecting ILLink configuration..."
 for file_name in "${ILLINK_FILES[@]}"; do
@@ -0,0 +1,182 @@
+using System.Globalization;
+using System.Text;
+
+namespace Benchmark
+{
+	// Compute bound managed code: parsing, floating point math and image processing.
+	// This is meant to be AOT compiled with both backends, see notes/aot.md, and compared with native/aot/compare_backends.py
+	public static class ComputeBenchmark
+	{
+		const double MinSeconds = 1.0;
+
+		public static void Run()
+		{
+			var numbers = BuildNumberText(20000);
+			var csv = BuildCsv(2000);
+			var image = BuildImage(256, 256);
+
+			Measure("parse_numbers", () => ParseNumbers(numbers));
+			Measure("parse_csv", () => ParseCsv(csv));
+			Measure("matrix_multiply", () => MatrixMultiply(64));
+			Measure("mandelbrot", () => Mandelbrot(128, 128, 64));
+			Measure("box_blur", () => BoxBlur(image, 256, 256));
+			Measure("crc32", () => Crc32(image));
+		}
+
+		static void Measure(string name, Func<double> workload)
+		{
+			double check = workload();
+
+			int iterations = 0;
+			var sw = System.Diagnostics.Stopwatch.StartNew();
+			while (sw.Elapsed.TotalSeconds < MinSeconds)
+			{
+				check += workload();
+				iterations++;
+			}
+
+			Program.Report($"compute_{name}", "iterations", iterations / sw.Elapsed.TotalSeconds, "iter/s");
+			GC.KeepAlive(check);
+		}
+
+		static string[] BuildNumberText(int count)
+		{
+			var rng = new Random(1234);
+			var result = new string[count];
+			for (int i = 0; i < count; i++)
+				result[i] = (i % 2 == 0 ? rng.Next() : rng.NextDouble() * 1e6).ToString(CultureInfo.InvariantCulture);
+			return result;
+		}
+
+		static double ParseNumbers(string[] numbers)
+		{
+			double sum = 0;
+			foreach (var text in numbers)
+			{
+				if (int.TryParse(text, NumberStyles.Integer, CultureInfo.InvariantCulture, out var i))
+					sum += i;
+				else
+					sum += double.Parse(text, CultureInfo.InvariantCulture);
+			}
+			return sum;
+		}
+
+		static string BuildCsv(int rows)
+		{
+			var sb = new StringBuilder();
+			for (int i = 0; i < rows; i++)
+				sb.Append(i).Append(",name").Append(i).Append(',').Append(i * 0.5).Append('\n');
+			return sb.ToString();
+		}
+
+		// Hand written field splitting, the kind of code that ends up in file format parsers
+		static double ParseCsv(string csv)
+		{
+			double sum = 0;
+			var span = csv.AsSpan();
+			while (!span.IsEmpty)
+			{
+				int end = span.IndexOf('\n');
+				var line = end < 0 ? span : span.Slice(0, end);
+				span = end < 0 ? ReadOnlySpan<char>.Empty : span.Slice(end + 1);
+
+				int field = 0;
+				while (!line.IsEmpty)
+				{
+					int comma = line.IndexOf(',');
+					var value = comma < 0 ? line : line.Slice(0, comma);
+					line = comma < 0 ? ReadOnlySpan<char>.Empty : line.Slice(comma + 1);
+
+					if (field == 0)
+						sum += int.Parse(value, NumberStyles.Integer, CultureInfo.InvariantCulture);
+					else if (field == 2)
+						sum += double.Parse(value, NumberStyles.Float, CultureInfo.InvariantCulture);
+					field++;
+				}
+			}
+			return sum;
+		}
+
+		static double MatrixMultiply(int n)
+		{
+			var a = new double[n * n];
+			var b = new double[n * n];
+			var c = new double[n * n];
+
+			for (int i = 0; i < n * n; i++)
+			{
+				a[i] = i % 7;
+				b[i] = i % 5;
+			}
+
+			for (int i = 0; i < n; i++)
+				for (int k = 0; k < n; k++)
+				{
+					double v = a[i * n + k];
+					for (int j = 0; j < n; j++)
+						c[i * n + j] += v * b[k * n + j];
+				}
+
+			return c[n * n - 1];
+		}
+
+		static double Mandelbrot(int width, int height, int maxIterations)
+		{
+			int total = 0;
+			for (int y = 0; y < height; y++)
+				for (int x = 0; x < width; x++)
+				{
+					double cr = x * 3.0 / width - 2.0;
+					double ci = y * 2.0 / height - 1.0;
+					double zr = 0, zi = 0;
+					int i = 0;
+					while (i < maxIterations && zr * zr + zi * zi < 4.0)
+					{
+						double t = zr * zr - zi * zi + cr;
+						zi = 2 * zr * zi + ci;
+						zr = t;
+						i++;
+					}
+					total += i;
+				}
+			return total;
+		}
+
+		static byte[] BuildImage(int width, int height)
+		{
+			var image = new byte[width * height * 4];
+			for (int i = 0; i < image.Length; i++)
+				image[i] = (byte)(i * 31 + (i >> 8));
+			return image;
+		}
+
+		// 3x3 box blur over an RGBA image
+		static double BoxBlur(byte[] source, int width, int height)
+		{
+			var dest = new byte[source.Length];
+			for (int y = 1; y < height - 1; y++)
+				for (int x = 1; x < width - 1; x++)
+					for (int c = 0; c < 4; c++)
+					{
+						int sum = 0;
+						for (int dy = -1; dy <= 1; dy++)
+							for (int dx = -1; dx <= 1; dx++)
+								sum += source[((y + dy) * width + (x + dx)) * 4 + c];
+						dest[(y * width + x) * 4 + c] = (byte)(sum / 9);
+					}
+			return dest[dest.Length / 2];
+		}
+
+		static double Crc32(byte[] data)
+		{
+			uint crc = 0xFFFFFFFF;
+			foreach (var b in data)
+			{
+				crc ^= b;
+				for (int k = 0; k < 8; k++)
+					crc = (crc >> 1) ^ (0xEDB88320 & (uint)-(int)(crc & 1));
+			}
+			return ~crc;
+		}
+	}
+}
@@ -0,0 +1,78 @@
+using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+using System.Runtime.InteropServices;
+
+namespace Benchmark
+{
+	// Host name lookups per second through Dns.GetHostEntry, which calls SystemNative_GetHostEntryForName.
+	// On switch the first lookup of each name goes to the sfdnsres service and the others come from the cache in native/shared/dns_cache.c
+	public static class DnsBenchmark
+	{
+		const int Lookups = 200;
+
+		// Same layout as struct DnsCacheStats in dns_cache.h
+		[StructLayout(LayoutKind.Sequential)]
+		struct DnsCacheStats
+		{
+			public ulong Hits;
+			public ulong NegativeHits;
+			public ulong Misses;
+			public ulong Evictions;
+			public int Entries;
+			public int Capacity;
+		}
+
+		[DllImport("__Internal")] static extern void dns_cache_get_stats(out DnsCacheStats stats);
+		[DllImport("__Internal")] static extern void dns_cache_clear();
+
+		public static void Run()
+		{
+			Measure("dns_localhost", "localhost");
+			Measure("dns_remote", "example.com");
+			// .invalid never resolves, this measures the negative cache
+			Measure("dns_missing", "mono-nx.invalid");
+
+			if (Program.IsSwitch)
+			{
+				dns_cache_get_stats(out var stats);
+				Program.Log($"DNS cache: {stats.Hits} hits, {stats.NegativeHits} negative hits, {stats.Misses} misses, {stats.Evictions} evictions, {stats.Entries}/{stats.Capacity} entries");
+			}
+		}
+
+		static void Measure(string name, string host)
+		{
+			if (Program.IsSwitch)
+				dns_cache_clear();
+
+			// The first lookup is the one that reaches the resolver
+			var first = Stopwatch.StartNew();
+			if (!Lookup(host))
+			{
+				Program.Log($"{name}: {host} failed to resolve, skipping");
+				return;
+			}
+			Program.Report(name, "first", first.Elapsed.TotalMilliseconds, "ms");
+
+			var sw = Stopwatch.StartNew();
+			for (int i = 0; i < Lookups; i++)
+				Lookup(host);
+
+			Program.Report(name, "repeated", Lookups / sw.Elapsed.TotalSeconds, "lookup/s");
+		}
+
+		// A name that doesn't exist counts as resolved, only network errors are failures
+		static bool Lookup(string host)
+		{
+			try
+			{
+				Dns.GetHostEntry(host);
+				return true;
+			}
+			catch (SocketException ex)
+			{
+				return ex.SocketErrorCode == SocketError.HostNotFound;
+			}
+		}
+	}
+}
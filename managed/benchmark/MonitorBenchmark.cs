@@ -0,0 +1,131 @@
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+
+namespace Benchmark
+{
+	// Contention on LowLevelMonitor, the lock and condition variable behind LowLevelLock and the portable thread pool.
+	// The PAL functions are called directly, on switch they resolve to native/shared/low_level_monitor.c unless native_monitor = false in config.ini
+	public static class MonitorBenchmark
+	{
+		const double MinSeconds = 2.0;
+
+		[DllImport("libSystem.Native", EntryPoint = "SystemNative_LowLevelMonitor_Create")] static extern nint Create();
+		[DllImport("libSystem.Native", EntryPoint = "SystemNative_LowLevelMonitor_Destroy")] static extern void Destroy(nint monitor);
+		[DllImport("libSystem.Native", EntryPoint = "SystemNative_LowLevelMonitor_Acquire")] static extern void Acquire(nint monitor);
+		[DllImport("libSystem.Native", EntryPoint = "SystemNative_LowLevelMonitor_Release")] static extern void Release(nint monitor);
+		[DllImport("libSystem.Native", EntryPoint = "SystemNative_LowLevelMonitor_Wait")] static extern void Wait(nint monitor);
+		[DllImport("libSystem.Native", EntryPoint = "SystemNative_LowLevelMonitor_Signal_Release")] static extern void SignalRelease(nint monitor);
+
+		public static void Run()
+		{
+			foreach (var threads in new[] { 2, 3 })
+				Handoff($"monitor_handoff_{threads}", threads);
+
+			PingPong("monitor_pingpong");
+
+			foreach (var chains in new[] { 1, 3 })
+				PoolChains($"monitor_pool_chain_{chains}", chains);
+		}
+
+		// Threads taking turns on one lock with a short critical section, the case the spinning is for
+		static void Handoff(string name, int threads)
+		{
+			var monitor = Create();
+			long total = 0;
+			var sw = Stopwatch.StartNew();
+
+			var workers = Enumerable.Range(0, threads).Select(_ => new Thread(() =>
+			{
+				long local = 0;
+				while (sw.Elapsed.TotalSeconds < MinSeconds)
+				{
+					for (int i = 0; i < 1000; i++)
+					{
+						Acquire(monitor);
+						local++;
+						Release(monitor);
+					}
+				}
+				Interlocked.Add(ref total, local);
+			})).ToList();
+
+			workers.ForEach(t => t.Start());
+			workers.ForEach(t => t.Join());
+
+			Program.Report(name, "throughput", total / sw.Elapsed.TotalSeconds, "op/s");
+			Destroy(monitor);
+		}
+
+		// Two threads passing a turn back and forth, every round is a wait and a signal on each side
+		static void PingPong(string name)
+		{
+			var monitor = Create();
+			int turn = 0;
+			bool stop = false;
+			long rounds = 0;
+
+			void Player(int me)
+			{
+				while (true)
+				{
+					Acquire(monitor);
+					while (turn != me && !stop)
+						Wait(monitor);
+
+					if (stop)
+					{
+						SignalRelease(monitor);
+						return;
+					}
+
+					if (me == 0)
+						rounds++;
+					turn = 1 - me;
+					SignalRelease(monitor);
+				}
+			}
+
+			var players = new[] { new Thread(() => Player(0)), new Thread(() => Player(1)) };
+			var sw = Stopwatch.StartNew();
+			foreach (var t in players)
+				t.Start();
+
+			Thread.Sleep(TimeSpan.FromSeconds(MinSeconds));
+
+			Acquire(monitor);
+			stop = true;
+			var seconds = sw.Elapsed.TotalSeconds;
+			var completed = rounds;
+			SignalRelease(monitor);
+
+			foreach (var t in players)
+				t.Join();
+
+			Program.Report(name, "throughput", completed / seconds, "round/s");
+			Destroy(monitor);
+		}
+
+		// Work items that each queue the next one, the pool keeps waking workers and going through its locks
+		static void PoolChains(string name, int chains)
+		{
+			long items = 0;
+			var sw = Stopwatch.StartNew();
+			using var done = new CountdownEvent(chains);
+
+			void Step(object? _)
+			{
+				Interlocked.Increment(ref items);
+				if (sw.Elapsed.TotalSeconds < MinSeconds)
+					ThreadPool.UnsafeQueueUserWorkItem(Step, null);
+				else
+					done.Signal();
+			}
+
+			for (int i = 0; i < chains; i++)
+				ThreadPool.UnsafeQueueUserWorkItem(Step, null);
+
+			done.Wait();
+			Program.Report(name, "throughput", Interlocked.Read(ref items) / sw.Elapsed.TotalSeconds, "items/s");
+		}
+	}
+}
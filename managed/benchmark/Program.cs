@@ -0,0 +1,114 @@
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+
+namespace Benchmark
+{
+	public class Program
+	{
+		[DllImport("__Internal")] static extern void console_ensure_init();
+		[DllImport("__Internal")] static extern void console_update();
+		[DllImport("__Internal")] static extern nint application_interp_options();
+		[DllImport("__Internal")] static extern nint application_execution_mode();
+
+		public static bool IsSwitch = OperatingSystem.IsOSPlatform("libnx");
+
+		// Benchmarks are selected by name from the command line, on switch we don't get any argument so everything runs.
+		static readonly Dictionary<string, Action> Benchmarks = new()
+		{
+			["random_read"] = RandomReadBenchmark.Run,
+			["workloads"] = WorkloadBenchmark.Run,
+			["compute"] = ComputeBenchmark.Run,
+			["threadpool"] = ThreadPoolBenchmark.Run,
+			["sockets"] = SocketBenchmark.Run,
+			["udp"] = UdpBenchmark.Run,
+			["sendfile"] = SendFileBenchmark.Run,
+			["dns"] = DnsBenchmark.Run,
+			["random"] = RandomBenchmark.Run,
+			["monitor"] = MonitorBenchmark.Run,
+		};
+
+		public static int Main(string[] args)
+		{
+			// This is a workaround for an issue in the interpreter builds. See the writeup for more info.
+			AppContext.SetSwitch("System.Resources.UseSystemResourceKeys", true);
+
+			if (IsSwitch)
+				console_ensure_init();
+
+			// Tags the log so runs with different [interp] and [jit] settings can be told apart, see native/interpreter/interp_bench.py
+			if (IsSwitch)
+			{
+				Log($"CONFIG mode {Marshal.PtrToStringUTF8(application_execution_mode())}");
+				Log($"CONFIG interp {InterpOptions()}");
+			}
+
+			var selected = args.Length > 0 ? args : Benchmarks.Keys.ToArray();
+
+			foreach (var name in selected)
+			{
+				if (!Benchmarks.TryGetValue(name, out var bench))
+				{
+					Console.WriteLine($"Unknown benchmark {name}, available: {string.Join(", ", Benchmarks.Keys)}");
+					continue;
+				}
+
+				Log($"--- {name} ---");
+
+				try
+				{
+					bench();
+				}
+				catch (Exception ex)
+				{
+					Log($"{name} failed: {ex}");
+				}
+			}
+
+			Log("DONE !");
+
+			if (IsSwitch)
+			{
+				Console.WriteLine("Closing in 10 seconds");
+				console_update();
+				Thread.Sleep(10 * 1000);
+			}
+
+			return 0;
+		}
+
+		static string InterpOptions()
+		{
+			var options = Marshal.PtrToStringUTF8(application_interp_options());
+			return string.IsNullOrEmpty(options) ? "default" : options;
+		}
+
+		public static void Log(string message)
+		{
+			Console.WriteLine(message);
+
+			if (IsSwitch)
+				console_update();
+		}
+
+		// Prints a single result line in a stable format so it can be grepped from the udp or file log
+		public static void Report(string name, string metric, double value, string unit)
+		{
+			Log($"RESULT {name} {metric} {value:0.###} {unit}");
+		}
+
+		public static double Measure(Action action)
+		{
+			var sw = Stopwatch.StartNew();
+			action();
+			return sw.Elapsed.TotalSeconds;
+		}
+
+		// Scratch folder for benchmarks that need files, on switch this is on the sd card
+		public static string TempDir()
+		{
+			var dir = IsSwitch ? "/mono_bench_tmp" : Path.Combine(Path.GetTempPath(), "mono_bench_tmp");
+			Directory.CreateDirectory(dir);
+			return dir;
+		}
+	}
+}
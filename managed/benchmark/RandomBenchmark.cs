@@ -0,0 +1,65 @@
+using System.Diagnostics;
+using System.Security.Cryptography;
+
+namespace Benchmark
+{
+	// Small random requests, each one calls SystemNative_GetCryptographicallySecureRandomBytes or GetNonCryptographicallySecureRandomBytes.
+	// Run it with fast_random = false in config.ini to compare against the PAL asking the csrng service every time, see native/shared/secure_random.h
+	public static class RandomBenchmark
+	{
+		const double MinSeconds = 2.0;
+
+		public static void Run()
+		{
+			Measure("guid_new", () => Guid.NewGuid());
+
+			var bytes = new byte[16];
+			Measure("rng_fill_16", () => RandomNumberGenerator.Fill(bytes));
+
+			// The seed of a new Random comes from the non cryptographic entry point
+			Measure("random_new", () => new Random().Next());
+
+			MeasureThreads("guid_new_threads", 4, () => Guid.NewGuid());
+		}
+
+		static void Measure(string name, Action action)
+		{
+			action();
+
+			long count = 0;
+			var sw = Stopwatch.StartNew();
+			while (sw.Elapsed.TotalSeconds < MinSeconds)
+			{
+				for (int i = 0; i < 256; i++)
+					action();
+				count += 256;
+			}
+
+			Program.Report(name, "throughput", count / sw.Elapsed.TotalSeconds, "op/s");
+		}
+
+		// Every thread has its own generator, this checks that they don't contend on anything
+		static void MeasureThreads(string name, int threads, Action action)
+		{
+			long count = 0;
+			var sw = Stopwatch.StartNew();
+
+			var workers = Enumerable.Range(0, threads).Select(_ => new Thread(() =>
+			{
+				long local = 0;
+				while (sw.Elapsed.TotalSeconds < MinSeconds)
+				{
+					for (int i = 0; i < 256; i++)
+						action();
+					local += 256;
+				}
+				Interlocked.Add(ref count, local);
+			})).ToList();
+
+			workers.ForEach(t => t.Start());
+			workers.ForEach(t => t.Join());
+
+			Program.Report(name, "throughput", count / sw.Elapsed.TotalSeconds, "op/s");
+		}
+	}
+}
@@ -0,0 +1,117 @@
+using Microsoft.Win32.SafeHandles;
+
+namespace Benchmark
+{
+	// Multiple threads reading random blocks of the same file through one shared handle.
+	// RandomAccess.Read goes through SystemNative_PRead, each block is tagged with its own index so we can detect reads that landed at the wrong offset.
+	public static class RandomReadBenchmark
+	{
+		const int BlockSize = 4096;
+		const int BlockCount = 8 * 1024; // 32MB
+		const int ReadsPerThread = 2000;
+
+		public static void Run()
+		{
+			var path = Path.Combine(Program.TempDir(), "random_read.bin");
+			CreateFile(path);
+
+			try
+			{
+				using var handle = File.OpenHandle(path, FileMode.Open, FileAccess.Read, FileShare.Read, FileOptions.RandomAccess);
+
+				foreach (var threads in new[] { 1, 2, 4 })
+					RunWithThreads(handle, threads);
+
+				RunVectored(handle);
+			}
+			finally
+			{
+				File.Delete(path);
+			}
+		}
+
+		static void CreateFile(string path)
+		{
+			var block = new byte[BlockSize];
+			using var fs = new FileStream(path, FileMode.Create, FileAccess.Write, FileShare.None, 1024 * 1024);
+
+			for (int i = 0; i < BlockCount; i++)
+			{
+				BitConverter.TryWriteBytes(block, i);
+				fs.Write(block);
+			}
+		}
+
+		static void RunWithThreads(SafeFileHandle handle, int threadCount)
+		{
+			int errors = 0;
+			var threads = new List<Thread>();
+
+			var time = Program.Measure(() =>
+			{
+				for (int t = 0; t < threadCount; t++)
+				{
+					int seed = t;
+					threads.Add(new Thread(() =>
+					{
+						var rng = new Random(seed);
+						var buffer = new byte[BlockSize];
+
+						for (int i = 0; i < ReadsPerThread; i++)
+						{
+							int block = rng.Next(BlockCount);
+							int read = RandomAccess.Read(handle, buffer, (long)block * BlockSize);
+
+							if (read != BlockSize || BitConverter.ToInt32(buffer) != block)
+								Interlocked.Increment(ref errors);
+						}
+					}));
+				}
+
+				foreach (var thread in threads)
+					thread.Start();
+
+				foreach (var thread in threads)
+					thread.Join();
+			});
+
+			int totalReads = threadCount * ReadsPerThread;
+			var name = $"random_read_{threadCount}t";
+			Program.Report(name, "ops", totalReads / time, "reads/s");
+			Program.Report(name, "throughput", totalReads * (double)BlockSize / time / 1024 / 1024, "MB/s");
+			Program.Report(name, "errors", errors, "reads");
+		}
+
+		// Reads 4 scattered blocks per call into separate buffers through SystemNative_PReadV
+		static void RunVectored(SafeFileHandle handle)
+		{
+			const int VectorCount = 4;
+			int errors = 0;
+
+			var rng = new Random(1234);
+			var buffers = new Memory<byte>[VectorCount];
+			for (int i = 0; i < VectorCount; i++)
+				buffers[i] = new byte[BlockSize];
+
+			var time = Program.Measure(() =>
+			{
+				for (int i = 0; i < ReadsPerThread; i++)
+				{
+					int block = rng.Next(BlockCount - VectorCount);
+					long read = RandomAccess.Read(handle, buffers, (long)block * BlockSize);
+
+					if (read != BlockSize * VectorCount)
+						errors++;
+
+					for (int v = 0; v < VectorCount; v++)
+						if (BitConverter.ToInt32(buffers[v].Span) != block + v)
+							errors++;
+				}
+			});
+
+			Program.Report("random_readv", "ops", ReadsPerThread / time, "calls/s");
+			Program.Report("random_readv", "throughput", ReadsPerThread * (double)BlockSize * VectorCount / time / 1024 / 1024, "MB/s");
+			Program.Report("random_readv", "errors", errors, "reads");
+		}
+	}
+}
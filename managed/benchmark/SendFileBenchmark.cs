@@ -0,0 +1,92 @@
+using System.Net;
+using System.Net.Sockets;
+
+namespace Benchmark
+{
+	// Serves a large file over a loopback connection, Socket.SendFile goes through SystemNative_SendFile and native/shared/socket_sendfile.c
+	// while the managed path reads the file and sends it from C#, which is what static file servers do without SendFile.
+	public static class SendFileBenchmark
+	{
+		const int FileSize = 32 * 1024 * 1024;
+		const int ManagedBufferSize = 64 * 1024;
+		const int Runs = 3;
+
+		public static void Run()
+		{
+			var path = Path.Combine(Program.TempDir(), "sendfile.bin");
+			CreateFile(path);
+
+			try
+			{
+				Measure("sendfile_native", socket => socket.SendFile(path));
+				Measure("sendfile_managed", socket => SendManaged(socket, path));
+			}
+			finally
+			{
+				File.Delete(path);
+			}
+		}
+
+		static void CreateFile(string path)
+		{
+			var block = new byte[1024 * 1024];
+			new Random(1).NextBytes(block);
+
+			using var fs = new FileStream(path, FileMode.Create, FileAccess.Write, FileShare.None, 1024 * 1024);
+			for (int i = 0; i < FileSize / block.Length; i++)
+				fs.Write(block);
+		}
+
+		static void SendManaged(Socket socket, string path)
+		{
+			var buffer = new byte[ManagedBufferSize];
+			using var fs = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.Read, 1, FileOptions.SequentialScan);
+
+			int read;
+			while ((read = fs.Read(buffer)) > 0)
+				socket.Send(buffer.AsSpan(0, read));
+		}
+
+		// Reports the median of a few runs, each one a full transfer of the file on a new connection
+		static void Measure(string name, Action<Socket> send)
+		{
+			var speeds = new List<double>();
+
+			for (int i = 0; i < Runs; i++)
+			{
+				using var listener = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+				listener.Bind(new IPEndPoint(IPAddress.Loopback, 0));
+				listener.Listen(1);
+
+				using var client = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+				client.Connect(listener.LocalEndPoint!);
+				using var server = listener.Accept();
+
+				long received = 0;
+				var receiver = new Thread(() =>
+				{
+					var buffer = new byte[256 * 1024];
+					int read;
+					while ((read = client.Receive(buffer)) > 0)
+						received += read;
+				});
+				receiver.Start();
+
+				var seconds = Program.Measure(() =>
+				{
+					send(server);
+					server.Shutdown(SocketShutdown.Send);
+					receiver.Join();
+				});
+
+				if (received != FileSize)
+					throw new Exception($"{name}: received {received} bytes instead of {FileSize}");
+
+				speeds.Add(FileSize / seconds / (1024 * 1024));
+			}
+
+			speeds.Sort();
+			Program.Report(name, "throughput", speeds[speeds.Count / 2], "MB/s");
+		}
+	}
+}
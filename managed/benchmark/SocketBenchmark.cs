@@ -0,0 +1,140 @@
+using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+
+namespace Benchmark
+{
+	// Async socket throughput over loopback with many connections at once, every await goes through the SocketAsyncEngine.
+	// Compare the poll based SocketEventPort in native/shared/socket_event_port.c against the managed engine, see notes/sockets.md
+	public static class SocketBenchmark
+	{
+		const double MinSeconds = 2.0;
+		const int EchoSize = 1024;
+		const int BulkSize = 64 * 1024;
+
+		public static void Run()
+		{
+			foreach (var connections in new[] { 1, 8, 32 })
+				Echo(connections);
+
+			foreach (var connections in new[] { 1, 8 })
+				Bulk(connections);
+		}
+
+		// Every client sends a message and waits for the server to send it back, measures the latency of each wakeup
+		static void Echo(int connections)
+		{
+			RunConnections(connections, EchoServer, async (socket, stop) =>
+			{
+				var buffer = new byte[EchoSize];
+				long messages = 0;
+
+				while (!stop.IsCancellationRequested)
+				{
+					await socket.SendAsync(buffer, SocketFlags.None);
+					await ReceiveExactly(socket, buffer);
+					messages++;
+				}
+
+				return messages;
+			}, out var total, out var seconds);
+
+			Program.Report($"socket_echo_{connections}", "throughput", total / seconds, "msg/s");
+		}
+
+		// Clients send as fast as they can and the server only receives, measures how well the engine batches events
+		static void Bulk(int connections)
+		{
+			RunConnections(connections, DrainServer, async (socket, stop) =>
+			{
+				var buffer = new byte[BulkSize];
+				long bytes = 0;
+
+				while (!stop.IsCancellationRequested)
+					bytes += await socket.SendAsync(buffer, SocketFlags.None);
+
+				return bytes;
+			}, out var total, out var seconds);
+
+			Program.Report($"socket_bulk_{connections}", "throughput", total / seconds / (1024 * 1024), "MB/s");
+		}
+
+		static void RunConnections(int connections, Func<Socket, Task> server, Func<Socket, CancellationToken, Task<long>> client, out long total, out double seconds)
+		{
+			using var listener = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+			listener.Bind(new IPEndPoint(IPAddress.Loopback, 0));
+			listener.Listen(connections);
+
+			var clients = new List<Socket>();
+			var servers = new List<Task>();
+
+			try
+			{
+				for (int i = 0; i < connections; i++)
+				{
+					var socket = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp) { NoDelay = true };
+					socket.Connect(listener.LocalEndPoint!);
+					clients.Add(socket);
+
+					var accepted = listener.Accept();
+					accepted.NoDelay = true;
+					servers.Add(server(accepted));
+				}
+
+				using var stop = new CancellationTokenSource();
+				var sw = Stopwatch.StartNew();
+
+				var tasks = clients.Select(socket => Task.Run(() => client(socket, stop.Token))).ToArray();
+				stop.CancelAfter(TimeSpan.FromSeconds(MinSeconds));
+				Task.WaitAll(tasks);
+
+				seconds = sw.Elapsed.TotalSeconds;
+				total = tasks.Sum(t => t.Result);
+			}
+			finally
+			{
+				// Closing the clients ends the server loops
+				foreach (var socket in clients)
+				{
+					socket.Shutdown(SocketShutdown.Both);
+					socket.Dispose();
+				}
+			}
+
+			// Servers that were still sending see a reset, that's expected at this point
+			try { Task.WaitAll(servers.ToArray()); }
+			catch (AggregateException ex) when (ex.InnerExceptions.All(e => e is SocketException)) { }
+		}
+
+		static async Task EchoServer(Socket socket)
+		{
+			using (socket)
+			{
+				var buffer = new byte[EchoSize];
+				int read;
+				while ((read = await socket.ReceiveAsync(buffer, SocketFlags.None)) > 0)
+					await socket.SendAsync(buffer.AsMemory(0, read), SocketFlags.None);
+			}
+		}
+
+		static async Task DrainServer(Socket socket)
+		{
+			using (socket)
+			{
+				var buffer = new byte[BulkSize];
+				while (await socket.ReceiveAsync(buffer, SocketFlags.None) > 0) ;
+			}
+		}
+
+		static async Task ReceiveExactly(Socket socket, Memory<byte> buffer)
+		{
+			while (buffer.Length > 0)
+			{
+				int read = await socket.ReceiveAsync(buffer, SocketFlags.None);
+				if (read == 0)
+					throw new IOException("Connection closed");
+				buffer = buffer.Slice(read);
+			}
+		}
+	}
+}
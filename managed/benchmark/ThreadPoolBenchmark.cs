@@ -0,0 +1,101 @@
+using System.Diagnostics;
+
+namespace Benchmark
+{
+	// Thread pool throughput, the thread pool decides how many workers to run from the CPU utilization reported by SystemNative_GetCpuUtilization.
+	// Compare the results and the thread counts with the hook in native/shared/dl_shim_dotnet.c against a build with the PAL stub, which always reports an idle CPU.
+	public static class ThreadPoolBenchmark
+	{
+		const double MinSeconds = 2.0;
+
+		public static void Run()
+		{
+			Measure("cpu_items", CpuWorkItems);
+			Measure("blocking_items", BlockingWorkItems);
+			Measure("async_chains", AsyncChains);
+		}
+
+		// Runs the workload repeatedly for MinSeconds and reports the rate and the largest number of pool threads seen meanwhile
+		static void Measure(string name, Func<int> workload)
+		{
+			workload();
+
+			int maxThreads = ThreadPool.ThreadCount;
+			long items = 0;
+			var sw = Stopwatch.StartNew();
+			while (sw.Elapsed.TotalSeconds < MinSeconds)
+			{
+				items += workload();
+				maxThreads = Math.Max(maxThreads, ThreadPool.ThreadCount);
+			}
+
+			Program.Report($"threadpool_{name}", "throughput", items / sw.Elapsed.TotalSeconds, "items/s");
+			Program.Report($"threadpool_{name}", "max_threads", maxThreads, "threads");
+		}
+
+		// Short CPU bound items, more threads than cores only adds context switches
+		static int CpuWorkItems()
+		{
+			const int count = 2000;
+			using var done = new CountdownEvent(count);
+
+			for (int i = 0; i < count; i++)
+			{
+				ThreadPool.UnsafeQueueUserWorkItem(static state =>
+				{
+					int acc = 0;
+					for (int k = 0; k < 2000; k++)
+						acc = acc * 31 + k;
+					GC.KeepAlive(acc);
+					((CountdownEvent)state!).Signal();
+				}, done);
+			}
+
+			done.Wait();
+			return count;
+		}
+
+		// Items that block without using the CPU, the pool has to inject threads to keep making progress
+		static int BlockingWorkItems()
+		{
+			const int count = 32;
+			using var done = new CountdownEvent(count);
+
+			for (int i = 0; i < count; i++)
+			{
+				ThreadPool.UnsafeQueueUserWorkItem(static state =>
+				{
+					Thread.Sleep(20);
+					((CountdownEvent)state!).Signal();
+				}, done);
+			}
+
+			done.Wait();
+			return count;
+		}
+
+		// Async continuations that hop between workers, like the network code does
+		static int AsyncChains()
+		{
+			const int chains = 64;
+			const int steps = 50;
+
+			var tasks = new Task[chains];
+			for (int i = 0; i < chains; i++)
+				tasks[i] = Task.Run(async () =>
+				{
+					int acc = 0;
+					for (int s = 0; s < steps; s++)
+					{
+						await Task.Yield();
+						for (int k = 0; k < 200; k++)
+							acc = acc * 31 + k;
+					}
+					GC.KeepAlive(acc);
+				});
+
+			Task.WaitAll(tasks);
+			return chains * steps;
+		}
+	}
+}
@@ -0,0 +1,93 @@
+using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+
+namespace Benchmark
+{
+	// UDP packets per second over loopback. SendTo and ReceiveFrom go through SystemNative_SendMessage and SystemNative_ReceiveMessage
+	// with a single buffer, the buffer list overloads with several, see the sendmsg/recvmsg shims in native/shared/socket_msg.c
+	public static class UdpBenchmark
+	{
+		const double MinSeconds = 2.0;
+
+		public static void Run()
+		{
+			foreach (var size in new[] { 64, 1024 })
+				Measure($"udp_sendto_{size}", size, SendTo, ReceiveFrom);
+
+			Measure("udp_gather_1024", 1024, SendGather, ReceiveScatter);
+		}
+
+		// The factories build the send and receive steps once per run so the loops don't allocate
+		static void Measure(string name, int size, Func<Socket, EndPoint, byte[], Func<bool>> sender, Func<Socket, byte[], Func<bool>> receiver)
+		{
+			using var receiveSocket = new Socket(AddressFamily.InterNetwork, SocketType.Dgram, ProtocolType.Udp);
+			receiveSocket.Bind(new IPEndPoint(IPAddress.Loopback, 0));
+			receiveSocket.ReceiveTimeout = 200;
+
+			using var sendSocket = new Socket(AddressFamily.InterNetwork, SocketType.Dgram, ProtocolType.Udp);
+			sendSocket.Connect(receiveSocket.LocalEndPoint!);
+
+			long received = 0;
+			var receive = receiver(receiveSocket, new byte[size]);
+			var receiveThread = new Thread(() =>
+			{
+				try
+				{
+					while (receive())
+						received++;
+				}
+				catch (SocketException ex) when (ex.SocketErrorCode == SocketError.TimedOut) { }
+			});
+			receiveThread.Start();
+
+			var send = sender(sendSocket, receiveSocket.LocalEndPoint!, new byte[size]);
+			long sent = 0;
+			var sw = Stopwatch.StartNew();
+			while (sw.Elapsed.TotalSeconds < MinSeconds)
+			{
+				// Check the time every few packets, Stopwatch is not free either
+				for (int i = 0; i < 64; i++)
+					if (send())
+						sent++;
+			}
+			var seconds = sw.Elapsed.TotalSeconds;
+
+			receiveThread.Join();
+
+			Program.Report(name, "sent", sent / seconds, "pkt/s");
+			Program.Report(name, "received", received / seconds, "pkt/s");
+			Program.Report(name, "loss", sent == 0 ? 0 : 100.0 * (sent - received) / sent, "%");
+		}
+
+		static Func<bool> SendTo(Socket socket, EndPoint target, byte[] packet)
+		{
+			return () => socket.SendTo(packet, SocketFlags.None, target) == packet.Length;
+		}
+
+		static Func<bool> ReceiveFrom(Socket socket, byte[] buffer)
+		{
+			EndPoint from = new IPEndPoint(IPAddress.Any, 0);
+			return () => socket.ReceiveFrom(buffer, SocketFlags.None, ref from) > 0;
+		}
+
+		// A small header and the payload in separate buffers, like a protocol that frames its packets
+		static Func<bool> SendGather(Socket socket, EndPoint target, byte[] packet)
+		{
+			var segments = Split(packet);
+			return () => socket.Send(segments) == packet.Length;
+		}
+
+		static Func<bool> ReceiveScatter(Socket socket, byte[] buffer)
+		{
+			var segments = Split(buffer);
+			return () => socket.Receive(segments) > 0;
+		}
+
+		static List<ArraySegment<byte>> Split(byte[] buffer) => new()
+		{
+			new ArraySegment<byte>(buffer, 0, 16),
+			new ArraySegment<byte>(buffer, 16, buffer.Length - 16),
+		};
+	}
+}
@@ -0,0 +1,144 @@
+using System.Diagnostics;
+using System.Text;
+
+namespace Benchmark
+{
+	// The CPU bound parts of managed/example in tight loops. Run this with mono_nx.nro and mono_nx_mixed.nro and compare the results,
+	// user_code only runs code from this assembly so it should be the same in both modes while the others mostly run framework code.
+	public static class WorkloadBenchmark
+	{
+		const double MinSeconds = 1.0;
+
+		public static void Run()
+		{
+			Measure("list", ListWorkload);
+			Measure("delegates", DelegateWorkload);
+			Measure("dictionary", DictionaryWorkload);
+			Measure("linq", LinqWorkload);
+			Measure("strings", StringWorkload);
+			Measure("exceptions", ExceptionWorkload);
+			Measure("stack_trace", StackTraceWorkload);
+			Measure("user_code", UserCodeWorkload);
+		}
+
+		// Repeats the workload until at least MinSeconds have elapsed so that slow workloads still get a few iterations
+		static void Measure(string name, Func<int> workload)
+		{
+			// Warm up, the first run pays for class initialization and loading the AOT images
+			int check = workload();
+
+			int iterations = 0;
+			var sw = Stopwatch.StartNew();
+			while (sw.Elapsed.TotalSeconds < MinSeconds)
+			{
+				check ^= workload();
+				iterations++;
+			}
+
+			Program.Report($"workload_{name}", "iterations", iterations / sw.Elapsed.TotalSeconds, "iter/s");
+			GC.KeepAlive(check);
+		}
+
+		static int ListWorkload()
+		{
+			var list = new List<int>();
+			for (int i = 0; i < 10000; i++)
+				list.Add(i);
+
+			list.Sort((a, b) => b.CompareTo(a));
+
+			int sum = 0;
+			foreach (var item in list)
+				sum += item;
+
+			return sum;
+		}
+
+		static int DelegateWorkload()
+		{
+			var funcs = new List<Func<int, int>>();
+			for (int i = 0; i < 1000; i++)
+			{
+				int j = i;
+				funcs.Add(x => x + j);
+			}
+
+			int sum = 0;
+			foreach (var func in funcs)
+				sum += func(10);
+
+			return sum;
+		}
+
+		static int DictionaryWorkload()
+		{
+			var dict = new Dictionary<string, int>();
+			for (int i = 0; i < 2000; i++)
+				dict[$"key{i}"] = i;
+
+			int sum = 0;
+			for (int i = 0; i < 2000; i++)
+				if (dict.TryGetValue($"key{i}", out var value))
+					sum += value;
+
+			return sum;
+		}
+
+		static int LinqWorkload()
+		{
+			return Enumerable.Range(0, 10000)
+				.Where(x => x % 3 == 0)
+				.Select(x => x * 2)
+				.OrderByDescending(x => x)
+				.Take(100)
+				.Sum();
+		}
+
+		static int StringWorkload()
+		{
+			var sb = new StringBuilder();
+			for (int i = 0; i < 1000; i++)
+				sb.Append("item ").Append(i).Append(", ");
+
+			var text = sb.ToString();
+			return text.Split(", ").Length + text.ToUpperInvariant().IndexOf("ITEM 999", StringComparison.Ordinal);
+		}
+
+		static int ExceptionWorkload()
+		{
+			int caught = 0;
+			for (int i = 0; i < 100; i++)
+			{
+				try
+				{
+					var action = () => { throw new InvalidOperationException("Test exception"); };
+					action();
+				}
+				catch (InvalidOperationException)
+				{
+					caught++;
+				}
+			}
+
+			return caught;
+		}
+
+		static int StackTraceWorkload()
+		{
+			return new StackTrace().ToString().Length;
+		}
+
+		static int UserCodeWorkload()
+		{
+			int a = 1, b = 1;
+			for (int i = 0; i < 100000; i++)
+			{
+				int c = (a + b) & 0xFFFF;
+				a = b;
+				b = c;
+			}
+
+			return b;
+		}
+	}
+}
@@ -46,6 +46,13 @@ namespace Example
 				TCPHttpTest();
 				HttpTest().Wait();
 
+				// Only when a server was given, see DownloadUrl
+				var downloadUrl = DownloadUrl(args);
+				if (downloadUrl != null)
+					HttpDownloadTest(downloadUrl).Wait();
+				else
+					Console.WriteLine($"Skipping the download test, pass a url as the first argument or set {DownloadUrlVariable}");
+
 				Console.WriteLine($"DONE !");
 			}
 			catch (Exception ex)
@@ -239,5 +246,50 @@ namespace Example
 			Console.WriteLine($"Status Code: {response.StatusCode}");
 			Console.WriteLine($"Response: {text}");
 		}
+
+		// Serve a large file on the local network with python3 -m http.server 8000, the [sockets] section of config.ini changes the buffers used here
+		const string DownloadUrlVariable = "MONONX_DOWNLOAD_URL";
+		const int DownloadRuns = 3;
+
+		static string? DownloadUrl(string[] args)
+		{
+			var url = args.Length > 0 ? args[0] : Environment.GetEnvironmentVariable(DownloadUrlVariable);
+			return string.IsNullOrEmpty(url) ? null : url;
+		}
+
+		public static async Task HttpDownloadTest(string url)
+		{
+			using var client = new HttpClient();
+			var buffer = new byte[256 * 1024];
+			var speeds = new List<double>();
+
+			for (int i = 0; i < DownloadRuns; i++)
+			{
+				var sw = Stopwatch.StartNew();
+				long total = 0;
+
+				using (var response = await client.GetAsync(url, HttpCompletionOption.ResponseHeadersRead))
+				{
+					response.EnsureSuccessStatusCode();
+					using var stream = await response.Content.ReadAsStreamAsync();
+
+					int read;
+					while ((read = await stream.ReadAsync(buffer)) > 0)
+						total += read;
+				}
+
+				var speed = total / sw.Elapsed.TotalSeconds / (1024 * 1024);
+				speeds.Add(speed);
+				Console.WriteLine($"Downloaded {total / 1024} KB in {sw.Elapsed.TotalSeconds:0.00}s");
+
+				if (IsSwitch)
+					console_update();
+			}
+
+			speeds.Sort();
+			// Same format as the benchmark project so native/compare_builds.py can read it
+			Console.WriteLine($"RESULT http_download throughput {speeds[speeds.Count / 2]:0.###} MB/s");
+			Console.WriteLine($"RESULT http_download best {speeds[^1]:0.###} MB/s");
+		}
 	}
 }
\ No newline at end of file
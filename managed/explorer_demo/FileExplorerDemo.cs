@@ -8,10 +8,13 @@ namespace ExplorerDemo
     {
         bool DemoWindow = false;
         bool HelpWindow = false;
+        bool FrameTimesWindow = false;
+
+        public readonly FrameStats Stats = new();
 
         string Cwd = null!;
-        DirectoryInfo[] Directories = [];
-        FileInfo[] Files = [];
+        List<DirectoryEntry> Directories = [];
+        List<DirectoryEntry> Files = [];
 
         string? Error = null;
 
@@ -25,16 +28,14 @@ namespace ExplorerDemo
             try
             {
                 Cwd = path;
-                var info = new DirectoryInfo(path);
-                Directories = info.GetDirectories();
-                Files = info.GetFiles();
+                LibnxDirectory.List(path, Directories, Files);
                 Error = null;
             }
             catch (Exception e)
             {
                 Error = e.Message;
-                Directories = [];
-                Files = [];
+                Directories.Clear();
+                Files.Clear();
                 Cwd = "/";
                 return;
             }
@@ -62,6 +63,9 @@ namespace ExplorerDemo
 
             if (HelpWindow)
                 AboutWindow();
+
+            if (FrameTimesWindow)
+                Stats.Render(ref FrameTimesWindow);
         }
 
         void AboutWindow() 
@@ -103,6 +107,10 @@ namespace ExplorerDemo
                     {
                         Program.DebugEvents = !Program.DebugEvents;
                     }
+                    if (ImGui.MenuItem("Frame times"))
+                    {
+                        FrameTimesWindow = !FrameTimesWindow;
+                    }
                     if (ImGui.MenuItem("Exit"))
                     {
                         SDL_Event quitEvent = new SDL_Event { type = SDL_EventType.SDL_QUIT };
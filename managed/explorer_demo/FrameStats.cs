@@ -0,0 +1,124 @@
+﻿using ImGuiNET;
+using System.Diagnostics;
+
+namespace ExplorerDemo
+{
+    // Frame time variance of the render loop, used to compare [threads] policies in config.ini, see notes/threads.md
+    // Background load keeps the thread pool busy so the workers compete with the main thread unless they are pinned to other cores.
+    internal class FrameStats
+    {
+        // About 10 seconds at 60 fps
+        const int WindowFrames = 600;
+
+        readonly double[] frameMs = new double[WindowFrames];
+        int frameCount = 0;
+        long lastTimestamp = 0;
+
+        public double Mean { get; private set; }
+        public double StdDev { get; private set; }
+        public double P99 { get; private set; }
+        public double Max { get; private set; }
+        public int Windows { get; private set; }
+
+        bool backgroundLoad = false;
+        int runningWorkers = 0;
+
+        public void Frame()
+        {
+            long now = Stopwatch.GetTimestamp();
+            if (lastTimestamp != 0)
+            {
+                frameMs[frameCount++] = Stopwatch.GetElapsedTime(lastTimestamp, now).TotalMilliseconds;
+                if (frameCount == WindowFrames)
+                {
+                    Compute();
+                    frameCount = 0;
+                }
+            }
+            lastTimestamp = now;
+        }
+
+        void Compute()
+        {
+            double sum = 0, max = 0;
+            foreach (var ms in frameMs)
+            {
+                sum += ms;
+                max = Math.Max(max, ms);
+            }
+
+            double mean = sum / frameMs.Length;
+            double variance = 0;
+            foreach (var ms in frameMs)
+                variance += (ms - mean) * (ms - mean);
+
+            var sorted = (double[])frameMs.Clone();
+            Array.Sort(sorted);
+
+            Mean = mean;
+            StdDev = Math.Sqrt(variance / frameMs.Length);
+            P99 = sorted[(int)(sorted.Length * 0.99)];
+            Max = max;
+            Windows++;
+
+            // Same format as managed/benchmark so the logs can be compared with the same tools
+            var load = backgroundLoad ? "load" : "idle";
+            Console.WriteLine($"RESULT explorer_frame_{load} mean {Mean:0.###} ms");
+            Console.WriteLine($"RESULT explorer_frame_{load} stddev {StdDev:0.###} ms");
+            Console.WriteLine($"RESULT explorer_frame_{load} p99 {P99:0.###} ms");
+            Console.WriteLine($"RESULT explorer_frame_{load} max {Max:0.###} ms");
+        }
+
+        public void Render(ref bool open)
+        {
+            if (!ImGui.Begin("Frame times", ref open))
+                return;
+
+            if (Windows == 0)
+                ImGui.Text($"Collecting {WindowFrames} frames...");
+            else
+            {
+                ImGui.Text($"Mean: {Mean:0.00} ms");
+                ImGui.Text($"Std dev: {StdDev:0.00} ms");
+                ImGui.Text($"99th percentile: {P99:0.00} ms");
+                ImGui.Text($"Max: {Max:0.00} ms");
+            }
+
+            ImGui.Text($"Thread pool threads: {ThreadPool.ThreadCount}");
+
+            if (ImGui.Checkbox("Background load", ref backgroundLoad) && backgroundLoad)
+                StartLoad();
+
+            ImGui.End();
+        }
+
+        // One CPU bound item per core, each requeues itself until the load is turned off
+        void StartLoad()
+        {
+            // Restart the window so the results only cover frames with the load running
+            frameCount = 0;
+
+            for (int i = runningWorkers; i < Environment.ProcessorCount; i++)
+            {
+                Interlocked.Increment(ref runningWorkers);
+                ThreadPool.UnsafeQueueUserWorkItem(static state => ((FrameStats)state!).LoadItem(), this);
+            }
+        }
+
+        void LoadItem()
+        {
+            if (!backgroundLoad)
+            {
+                Interlocked.Decrement(ref runningWorkers);
+                return;
+            }
+
+            int acc = 0;
+            for (int k = 0; k < 200000; k++)
+                acc = acc * 31 + k;
+            GC.KeepAlive(acc);
+
+            ThreadPool.UnsafeQueueUserWorkItem(static state => ((FrameStats)state!).LoadItem(), this);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+﻿using System.Buffers.Binary;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace ExplorerDemo
+{
+    internal record struct DirectoryEntry(string Name, string FullName, bool IsDirectory, long Length);
+
+    // DirectoryInfo.GetFiles() does one native call per entry plus a stat for each file, on the sd card every one of them is an fs IPC round trip.
+    // On switch we use the bulk listing exported by the libnx dlshim (native/shared/io_dirread.h) which returns many entries with their type and size per call.
+    internal static class LibnxDirectory
+    {
+        [DllImport("libnx")]
+        static extern nint extensionDirOpen([MarshalAs(UnmanagedType.LPUTF8Str)] string path);
+
+        [DllImport("libnx")]
+        static extern unsafe int extensionDirRead(nint handle, byte* buffer, int bufferSize);
+
+        [DllImport("libnx")]
+        static extern void extensionDirClose(nint handle);
+
+        // Must match struct DirReadEntry
+        const int EntryHeaderSize = 16;
+        const uint EntryTypeFile = 0;
+        const uint EntryTypeDirectory = 1;
+
+        const int BufferSize = 32 * 1024;
+
+        static readonly bool IsSwitch = OperatingSystem.IsOSPlatform("libnx");
+
+        public static void List(string path, List<DirectoryEntry> directories, List<DirectoryEntry> files)
+        {
+            directories.Clear();
+            files.Clear();
+
+            if (!IsSwitch || !TryListNative(path, directories, files))
+                ListManaged(path, directories, files);
+        }
+
+        static void ListManaged(string path, List<DirectoryEntry> directories, List<DirectoryEntry> files)
+        {
+            var info = new DirectoryInfo(path);
+
+            foreach (var dir in info.GetDirectories())
+                directories.Add(new DirectoryEntry(dir.Name, dir.FullName, true, 0));
+
+            foreach (var file in info.GetFiles())
+                files.Add(new DirectoryEntry(file.Name, file.FullName, false, file.Length));
+        }
+
+        static unsafe bool TryListNative(string path, List<DirectoryEntry> directories, List<DirectoryEntry> files)
+        {
+            var handle = extensionDirOpen(path);
+            if (handle == 0)
+                return false; // Let DirectoryInfo throw the appropriate exception
+
+            var buffer = new byte[BufferSize];
+
+            try
+            {
+                fixed (byte* ptr = buffer)
+                {
+                    int count;
+                    while ((count = extensionDirRead(handle, ptr, buffer.Length)) > 0)
+                    {
+                        int offset = 0;
+                        for (int i = 0; i < count; i++)
+                        {
+                            var record = buffer.AsSpan(offset);
+                            long size = BinaryPrimitives.ReadInt64LittleEndian(record);
+                            uint type = BinaryPrimitives.ReadUInt32LittleEndian(record.Slice(8));
+                            int nameLength = (int)BinaryPrimitives.ReadUInt32LittleEndian(record.Slice(12));
+
+                            var name = Encoding.UTF8.GetString(record.Slice(EntryHeaderSize, nameLength));
+                            var fullName = Path.Join(path, name);
+
+                            if (type == EntryTypeDirectory)
+                                directories.Add(new DirectoryEntry(name, fullName, true, 0));
+                            else if (type == EntryTypeFile)
+                                files.Add(new DirectoryEntry(name, fullName, false, size));
+
+                            offset += (EntryHeaderSize + nameLength + 7) & ~7;
+                        }
+                    }
+
+                    if (count < 0)
+                    {
+                        directories.Clear();
+                        files.Clear();
+                        return false;
+                    }
+                }
+            }
+            finally
+            {
+                extensionDirClose(handle);
+            }
+
+            return true;
+        }
+    }
+}
@@ -126,6 +126,8 @@ public static class Program
             SDL_RenderClear(SdlRenderer);
             ImGui_ImplSDLRenderer2_RenderDrawData(ImGui.GetDrawData());
             SDL_RenderPresent(SdlRenderer);
+
+            demo.Stats.Frame();
         }
     break_main_loop:
 
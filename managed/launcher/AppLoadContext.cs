@@ -0,0 +1,102 @@
+using System.Reflection;
+using System.Runtime.Loader;
+
+namespace Launcher
+{
+	// Each app gets its own context so it has its own copy of its assemblies and statics.
+	// Mono never frees load contexts, so one context per app is kept and reused by every launch of it. See notes/launcher.md
+	// Framework assemblies stay in the default context, they're loaded once and shared by every launch.
+	class AppLoadContext : AssemblyLoadContext
+	{
+		readonly string AppDirectory;
+
+		public AppLoadContext(string mainAssembly)
+			: base(Path.GetFileNameWithoutExtension(mainAssembly))
+		{
+			AppDirectory = Path.GetDirectoryName(mainAssembly) ?? "/";
+		}
+
+		protected override Assembly? Load(AssemblyName name)
+		{
+			// Anything the default context already has must come from there, otherwise the app would see its own copy of the framework types
+			foreach (var loaded in Default.Assemblies)
+				if (AssemblyName.ReferenceMatchesDefinition(name, loaded.GetName()))
+					return null;
+
+			// Dependencies that ship next to the app, everything else is probed by the default context
+			var path = Path.Combine(AppDirectory, name.Name + ".dll");
+			return File.Exists(path) ? LoadFromAssemblyPath(path) : null;
+		}
+	}
+
+	record LaunchResult(string Name, int ExitCode, double LoadMs, double RunMs, bool Reused, long HeapBefore, long HeapAfter)
+	{
+		public override string ToString() =>
+			$"{Name}: exit code {ExitCode}, {(Reused ? "already loaded" : $"load {LoadMs:0} ms")}, run {RunMs:0} ms, " +
+			$"managed heap {HeapBefore / 1024} KB -> {HeapAfter / 1024} KB";
+	}
+
+	static class AppRunner
+	{
+		// Keyed by the full path of the main assembly, launching an app again runs the assembly that is already loaded
+		static readonly Dictionary<string, Assembly> LoadedApps = new(StringComparer.OrdinalIgnoreCase);
+
+		public static LaunchResult Run(string path)
+		{
+			path = Path.GetFullPath(path);
+
+			long heapBefore = GC.GetTotalMemory(true);
+			var previousDirectory = Environment.CurrentDirectory;
+
+			int exitCode;
+			double loadMs, runMs;
+			bool reused;
+
+			try
+			{
+				// Apps expect to find their files relative to their own folder, like when launched by mono_nx.nro
+				Environment.CurrentDirectory = Path.GetDirectoryName(path) ?? "/";
+				(exitCode, loadMs, runMs, reused) = Execute(path);
+			}
+			finally
+			{
+				Environment.CurrentDirectory = previousDirectory;
+			}
+
+			return new LaunchResult(Path.GetFileName(path), exitCode, loadMs, runMs, reused, heapBefore, GC.GetTotalMemory(true));
+		}
+
+		static (int ExitCode, double LoadMs, double RunMs, bool Reused) Execute(string path)
+		{
+			var sw = System.Diagnostics.Stopwatch.StartNew();
+
+			bool reused = LoadedApps.TryGetValue(path, out var assembly);
+			if (!reused)
+			{
+				assembly = new AppLoadContext(path).LoadFromAssemblyPath(path);
+				LoadedApps.Add(path, assembly);
+			}
+
+			var entryPoint = assembly!.EntryPoint ?? throw new InvalidOperationException($"{Path.GetFileName(path)} has no entry point");
+			var arguments = entryPoint.GetParameters().Length == 0 ? null : new object[] { Array.Empty<string>() };
+
+			double loadMs = sw.Elapsed.TotalMilliseconds;
+			sw.Restart();
+
+			int exitCode = 0;
+			try
+			{
+				if (entryPoint.Invoke(null, arguments) is int code)
+					exitCode = code;
+			}
+			catch (TargetInvocationException ex) when (ex.InnerException is not null)
+			{
+				Console.WriteLine($"{assembly.GetName().Name} threw an exception: {ex.InnerException}");
+				exitCode = -1;
+			}
+
+			double runMs = sw.Elapsed.TotalMilliseconds;
+			return (exitCode, loadMs, runMs, reused);
+		}
+	}
+}
@@ -0,0 +1,137 @@
+using System.Runtime.InteropServices;
+
+namespace Launcher
+{
+	// Resident launcher: mono is initialized once and the apps picked here run one after the other in the same runtime.
+	// Only the first launch pays for the runtime startup, see notes/launcher.md
+	public class Program
+	{
+		[DllImport("__Internal")] static extern void console_ensure_init();
+		[DllImport("__Internal")] static extern void console_update();
+
+		const string DefaultAppFolder = "/switch";
+
+		public static int Main(string[] args)
+		{
+			// This is a workaround for an issue in the interpreter builds. See the writeup for more info.
+			AppContext.SetSwitch("System.Resources.UseSystemResourceKeys", true);
+
+			if (!OperatingSystem.IsOSPlatform("libnx"))
+			{
+				Console.WriteLine("The launcher is only for mono-nx");
+				return 1;
+			}
+
+			var folder = args.Length > 0 ? args[0] : DefaultAppFolder;
+			var apps = FindApps(folder);
+			int selected = 0;
+			string status = "";
+
+			console_ensure_init();
+			LibnxPad pad = new();
+
+			while (LibnxApplet.appletMainLoop())
+			{
+				pad.Update();
+				var down = pad.ButtonsDown;
+
+				if (down.HasFlag(HidNpadButton.Plus))
+					break;
+
+				if (apps.Count > 0)
+				{
+					if ((down & HidNpadButton.AnyUp) != 0)
+						selected = (selected + apps.Count - 1) % apps.Count;
+					if ((down & HidNpadButton.AnyDown) != 0)
+						selected = (selected + 1) % apps.Count;
+				}
+
+				if (down.HasFlag(HidNpadButton.A) && apps.Count > 0)
+				{
+					status = Launch(apps[selected]);
+
+					// The app may have disposed the console to use SDL and may have added or removed files
+					console_ensure_init();
+					apps = FindApps(folder);
+					selected = Math.Min(selected, Math.Max(apps.Count - 1, 0));
+					continue;
+				}
+
+				Draw(folder, apps, selected, status);
+				console_update();
+			}
+
+			return 0;
+		}
+
+		static string Launch(string path)
+		{
+			Console.Write("\x1b[1;1H\x1b[2J");
+			Console.WriteLine($"Launching {path}");
+			console_update();
+
+			try
+			{
+				var result = AppRunner.Run(path);
+				Console.WriteLine(result);
+				return result.ToString();
+			}
+			catch (Exception ex)
+			{
+				Console.WriteLine($"Failed to launch {path}: {ex}");
+				return $"Failed to launch {Path.GetFileName(path)}: {ex.Message}";
+			}
+		}
+
+		// Dlls in the folder and in its subfolders when they're named like the subfolder, eg. explorer_demo/explorer_demo.dll
+		static List<string> FindApps(string folder)
+		{
+			var apps = new List<string>();
+			var self = typeof(Program).Assembly.GetName().Name + ".dll";
+
+			try
+			{
+				foreach (var file in Directory.GetFiles(folder, "*.dll"))
+					if (!Path.GetFileName(file).Equals(self, StringComparison.OrdinalIgnoreCase))
+						apps.Add(file);
+
+				foreach (var dir in Directory.GetDirectories(folder))
+				{
+					var dll = Path.Combine(dir, Path.GetFileName(dir) + ".dll");
+					if (File.Exists(dll))
+						apps.Add(dll);
+				}
+			}
+			catch (IOException ex)
+			{
+				Console.WriteLine($"Can't list {folder}: {ex.Message}");
+			}
+
+			apps.Sort(StringComparer.OrdinalIgnoreCase);
+			return apps;
+		}
+
+		static void Draw(string folder, List<string> apps, int selected, string status)
+		{
+			// The console class is not implemented so Console.Clear() will throw NotImplementedException, use escape codes instead
+			Console.Write("\x1b[1;1H\x1b[2J");
+			Console.WriteLine($"mono-nx launcher, apps in {folder}");
+			Console.WriteLine("");
+
+			if (apps.Count == 0)
+				Console.WriteLine("No apps found");
+
+			for (int i = 0; i < apps.Count; i++)
+				Console.WriteLine($"{(i == selected ? ">" : " ")} {Path.GetRelativePath(folder, apps[i])}");
+
+			Console.WriteLine("");
+			Console.WriteLine("A: launch  +: exit");
+
+			if (status.Length > 0)
+			{
+				Console.WriteLine("");
+				Console.WriteLine($"Last run: {status}");
+			}
+		}
+	}
+}
@@ -15,4 +15,67 @@ fi
 
 dotnet build pad_input/pad_input.csproj
 dotnet build example/example.csproj
-dotnet build explorer_demo/explorer_demo.csproj
\ No newline at end of file
+dotnet build explorer_demo/explorer_demo.csproj
+dotnet build benchmark/benchmark.csproj
+dotnet build launcher/launcher.csproj
+
+# MONO_NX_PACK=1 also packs each app in PACK_APPS in a .bundle for the interpreter, see notes/bundle.md
+# Every app gets its own trimmed copy of the framework, only the types it uses are left so mono has less metadata to load.
+# If <app>/bundle.ini exists it's embedded in the bundle and applied on top of config.ini when the app runs.
+# The launcher is never packed since it loads arbitrary apps that need the whole framework.
+if [ "$MONO_NX_PACK" != "1" ]; then
+    exit 0
+fi
+
+PACK_APPS=${PACK_APPS:-"example benchmark explorer_demo"}
+
+# Trim against the runtime the bundle will run with, MONO_NX_CONFIG=Release for mono_nx_release.nro
+MONO_NX_CONFIG=${MONO_NX_CONFIG:-Debug}
+
+# Same ILLink invocation as native/aot/build_aot.sh
+ILLINK=$MONO_NX_ROOT/artifacts/bin/Mono.Linker/$MONO_NX_CONFIG/net9.0/illink.dll
+ILLINK_CFG=$MONO_NX_ROOT/src/mono/System.Private.CoreLib/src/ILLink/ILLink.Descriptors.xml
+ILLINK_CFG1=$MONO_NX_ROOT/src/mono/System.Private.CoreLib/src/ILLink/ILLink.LinkAttributes.xml
+
+LIB_ROOT=$MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.$MONO_NX_CONFIG/
+FRAMEWORK_ROOT=$MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-$MONO_NX_CONFIG-arm64/
+
+if [ ! -f $ILLINK ]; then
+    echo "$ILLINK was not found, build mono with MONO_NX_CONFIG=$MONO_NX_CONFIG first"
+    exit 1
+fi
+
+mkdir -p bundles
+
+for app in $PACK_APPS; do
+    echo Packing $app...
+
+    TRIMMED=trimmed/$app
+    rm -rf $TRIMMED
+
+    dotnet $ILLINK -x $ILLINK_CFG -x $ILLINK_CFG1 --feature System.Resources.UseSystemResourceKeys true --deterministic \
+        -d $LIB_ROOT -d $FRAMEWORK_ROOT --trim-mode link -out $TRIMMED -a $app/bin/Debug/net9.0/$app.dll
+
+    BUNDLE_CONFIG=
+    if [ -f $app/bundle.ini ]; then
+        BUNDLE_CONFIG="-c $app/bundle.ini"
+    fi
+
+    python3 ../native/interpreter/pack_bundle.py -o bundles/$app.bundle -m $TRIMMED/$app.dll $BUNDLE_CONFIG $TRIMMED/
+
+    # Compare against what a loose deployment would load from /mono for the same assemblies
+    TRIMMED_KB=$(du -ck $TRIMMED/*.dll | tail -1 | cut -f1)
+    FULL_KB=0
+    for dll in $TRIMMED/*.dll; do
+        name=$(basename $dll)
+        if [ -f $LIB_ROOT/$name ]; then
+            FULL_KB=$((FULL_KB + $(du -k $LIB_ROOT/$name | cut -f1)))
+        elif [ -f $FRAMEWORK_ROOT/$name ]; then
+            FULL_KB=$((FULL_KB + $(du -k $FRAMEWORK_ROOT/$name | cut -f1)))
+        else
+            FULL_KB=$((FULL_KB + $(du -k $dll | cut -f1)))
+        fi
+    done
+
+    echo "$app: $(ls $TRIMMED/*.dll | wc -l) assemblies, ${TRIMMED_KB} KB trimmed, ${FULL_KB} KB untrimmed"
+done
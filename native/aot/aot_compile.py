@@ -0,0 +1,448 @@
+#!/usr/bin/env python3
+
+# Runs mono-aot-cross over a set of assemblies in parallel, reusing object files from previous runs.
+# Called by build_aot.sh, see notes/aot.md
+# Also generates the STATIC_MONO_SYM registrations and the list of object files to link so the two can't drift apart.
+#
+# The cache key of an assembly is made of the compiler options, the compiler binary, the assembly MVID and the MVIDs of every
+# assembly it references, directly or not. Mono refuses AOT images that were compiled against a different version of a referenced
+# assembly so a change in CoreLib invalidates everything while a change in the app only recompiles the app.
+#
+# With --dedup the generic instantiations that would be compiled into every module are emitted once in the given assembly instead,
+# the other assemblies are compiled with dedup-skip and the dedup module is compiled with all of them so its key depends on every MVID.
+
+import argparse
+import concurrent.futures
+import hashlib
+import json
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import time
+
+# ECMA-335 II.24.2.6, we only need enough of the metadata tables to reach Module and AssemblyRef
+
+TABLE_MODULE = 0x00
+TABLE_ASSEMBLY_REF = 0x23
+
+STRING = "str"
+GUID = "guid"
+BLOB = "blob"
+
+# Coded index kinds: (tag bits, referenced tables)
+TYPE_DEF_OR_REF = (2, [0x02, 0x01, 0x1B])
+HAS_CONSTANT = (2, [0x04, 0x08, 0x17])
+HAS_CUSTOM_ATTRIBUTE = (5, [0x06, 0x04, 0x01, 0x02, 0x08, 0x09, 0x0A, 0x00, 0x0E, 0x17, 0x14, 0x11, 0x1A, 0x1B, 0x20, 0x23, 0x26, 0x27, 0x28, 0x2A, 0x2C, 0x2B])
+HAS_FIELD_MARSHAL = (1, [0x04, 0x08])
+HAS_DECL_SECURITY = (2, [0x02, 0x06, 0x20])
+MEMBER_REF_PARENT = (3, [0x02, 0x01, 0x1A, 0x06, 0x1B])
+HAS_SEMANTICS = (1, [0x14, 0x17])
+METHOD_DEF_OR_REF = (1, [0x06, 0x0A])
+MEMBER_FORWARDED = (1, [0x04, 0x06])
+CUSTOM_ATTRIBUTE_TYPE = (3, [0x06, 0x0A])
+RESOLUTION_SCOPE = (2, [0x00, 0x1A, 0x23, 0x01])
+
+# Columns of the tables that precede AssemblyRef, ints are fixed sizes, other ints are simple indexes into that table
+TABLE_COLUMNS = {
+    0x00: [2, STRING, GUID, GUID, GUID],
+    0x01: [RESOLUTION_SCOPE, STRING, STRING],
+    0x02: [4, STRING, STRING, TYPE_DEF_OR_REF, ("index", 0x04), ("index", 0x06)],
+    0x03: [("index", 0x04)],
+    0x04: [2, STRING, BLOB],
+    0x05: [("index", 0x06)],
+    0x06: [4, 2, 2, STRING, BLOB, ("index", 0x08)],
+    0x07: [("index", 0x08)],
+    0x08: [2, 2, STRING],
+    0x09: [("index", 0x02), TYPE_DEF_OR_REF],
+    0x0A: [MEMBER_REF_PARENT, STRING, BLOB],
+    0x0B: [2, HAS_CONSTANT, BLOB],
+    0x0C: [HAS_CUSTOM_ATTRIBUTE, CUSTOM_ATTRIBUTE_TYPE, BLOB],
+    0x0D: [HAS_FIELD_MARSHAL, BLOB],
+    0x0E: [2, HAS_DECL_SECURITY, BLOB],
+    0x0F: [2, 4, ("index", 0x02)],
+    0x10: [4, ("index", 0x04)],
+    0x11: [BLOB],
+    0x12: [("index", 0x02), ("index", 0x14)],
+    0x13: [("index", 0x14)],
+    0x14: [2, STRING, TYPE_DEF_OR_REF],
+    0x15: [("index", 0x02), ("index", 0x17)],
+    0x16: [("index", 0x17)],
+    0x17: [2, STRING, BLOB],
+    0x18: [2, ("index", 0x06), HAS_SEMANTICS],
+    0x19: [("index", 0x02), METHOD_DEF_OR_REF, METHOD_DEF_OR_REF],
+    0x1A: [STRING],
+    0x1B: [BLOB],
+    0x1C: [2, MEMBER_FORWARDED, STRING, ("index", 0x1A)],
+    0x1D: [4, ("index", 0x04)],
+    0x1E: [4, 4],
+    0x1F: [4],
+    0x20: [4, 2, 2, 2, 2, 4, BLOB, STRING, STRING],
+    0x21: [4],
+    0x22: [4, 4, 4],
+    0x23: [2, 2, 2, 2, 4, BLOB, STRING, STRING, BLOB],
+}
+
+
+class AssemblyInfo:
+    def __init__(self, path, mvid, references):
+        self.path = path
+        self.name = os.path.splitext(os.path.basename(path))[0]
+        self.mvid = mvid
+        self.references = references
+
+
+def read_metadata_root(data):
+    pe_offset = struct.unpack_from("<I", data, 0x3C)[0]
+    if data[pe_offset:pe_offset + 4] != b"PE\0\0":
+        raise ValueError("not a PE file")
+
+    coff = pe_offset + 4
+    section_count, = struct.unpack_from("<H", data, coff + 2)
+    optional_size, = struct.unpack_from("<H", data, coff + 16)
+    optional = coff + 20
+
+    magic, = struct.unpack_from("<H", data, optional)
+    data_directories = optional + (96 if magic == 0x10B else 112)
+    cli_rva, _ = struct.unpack_from("<II", data, data_directories + 14 * 8)
+
+    sections = []
+    for i in range(section_count):
+        header = optional + optional_size + i * 40
+        virtual_size, virtual_address, raw_size, raw_pointer = struct.unpack_from("<IIII", data, header + 8)
+        sections.append((virtual_address, max(virtual_size, raw_size), raw_pointer))
+
+    def rva_to_offset(rva):
+        for address, size, pointer in sections:
+            if address <= rva < address + size:
+                return rva - address + pointer
+        raise ValueError(f"rva {rva:x} is not in any section")
+
+    metadata_rva, = struct.unpack_from("<I", data, rva_to_offset(cli_rva) + 8)
+    return rva_to_offset(metadata_rva)
+
+
+def read_streams(data, root):
+    if struct.unpack_from("<I", data, root)[0] != 0x424A5342:
+        raise ValueError("bad metadata signature")
+
+    version_length, = struct.unpack_from("<I", data, root + 12)
+    offset = root + 16 + version_length
+    stream_count, = struct.unpack_from("<H", data, offset + 2)
+    offset += 4
+
+    streams = {}
+    for _ in range(stream_count):
+        stream_offset, size = struct.unpack_from("<II", data, offset)
+        end = data.index(b"\0", offset + 8)
+        name = data[offset + 8:end].decode("ascii")
+        offset = (end + 4) & ~3
+        streams[name] = (root + stream_offset, size)
+
+    return streams
+
+
+def read_string(data, heap, index):
+    start = heap + index
+    return data[start:data.index(b"\0", start)].decode("utf-8")
+
+
+def read_assembly_info(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    streams = read_streams(data, read_metadata_root(data))
+    tables_offset, _ = streams.get("#~") or streams["#-"]
+    strings_heap, _ = streams["#Strings"]
+    guid_heap, _ = streams["#GUID"]
+
+    heap_sizes = data[tables_offset + 6]
+    valid, = struct.unpack_from("<Q", data, tables_offset + 8)
+
+    rows = {}
+    offset = tables_offset + 24
+    for table in range(64):
+        if valid & (1 << table):
+            rows[table], = struct.unpack_from("<I", data, offset)
+            offset += 4
+
+    # Extra data flag, only present in uncompressed EnC metadata
+    if heap_sizes & 0x40:
+        offset += 4
+
+    string_size = 4 if heap_sizes & 0x01 else 2
+    guid_size = 4 if heap_sizes & 0x02 else 2
+    blob_size = 4 if heap_sizes & 0x04 else 2
+
+    def column_size(column):
+        if isinstance(column, int):
+            return column
+        if column == STRING:
+            return string_size
+        if column == GUID:
+            return guid_size
+        if column == BLOB:
+            return blob_size
+        if column[0] == "index":
+            return 2 if rows.get(column[1], 0) < 0x10000 else 4
+        tag_bits, tables = column
+        largest = max(rows.get(t, 0) for t in tables)
+        return 2 if largest < (1 << (16 - tag_bits)) else 4
+
+    def read_index(at, size):
+        return struct.unpack_from("<H" if size == 2 else "<I", data, at)[0]
+
+    table_offsets = {}
+    for table in range(TABLE_ASSEMBLY_REF + 1):
+        table_offsets[table] = offset
+        row_size = sum(column_size(c) for c in TABLE_COLUMNS[table])
+        offset += row_size * rows.get(table, 0)
+
+    # Module has a single row, the MVID is its third column
+    module = table_offsets[TABLE_MODULE]
+    mvid_index = read_index(module + 2 + string_size, guid_size)
+    mvid = data[guid_heap + (mvid_index - 1) * 16:guid_heap + mvid_index * 16].hex()
+
+    references = []
+    columns = TABLE_COLUMNS[TABLE_ASSEMBLY_REF]
+    row_size = sum(column_size(c) for c in columns)
+    name_offset = sum(column_size(c) for c in columns[:6])
+    for i in range(rows.get(TABLE_ASSEMBLY_REF, 0)):
+        row = table_offsets[TABLE_ASSEMBLY_REF] + i * row_size
+        references.append(read_string(data, strings_heap, read_index(row + name_offset, string_size)))
+
+    return AssemblyInfo(path, mvid, references)
+
+
+def file_digest(path):
+    digest = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(1024 * 1024), b""):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+
+def is_dedup(args, assembly):
+    return args.dedup is not None and os.path.abspath(assembly.path) == os.path.abspath(args.dedup)
+
+
+def assembly_options(args, assembly):
+    if args.dedup is None:
+        return args.options
+    if is_dedup(args, assembly):
+        return f"{args.options},dedup-include={os.path.basename(assembly.path)}"
+    return f"{args.options},dedup-skip"
+
+
+def compute_keys(args, assemblies, compiler_digest):
+    by_name = {a.name: a for a in assemblies}
+    keys = {}
+
+    for assembly in assemblies:
+        if is_dedup(args, assembly):
+            # The shared instances come from every assembly
+            seen = set(by_name)
+        else:
+            # Transitive closure of the references that are part of this build, anything else is not compiled by us
+            seen = {assembly.name}
+            pending = list(assembly.references)
+            while pending:
+                name = pending.pop()
+                if name in seen or name not in by_name:
+                    continue
+                seen.add(name)
+                pending.extend(by_name[name].references)
+
+        digest = hashlib.sha256()
+        digest.update(assembly_options(args, assembly).encode())
+        digest.update(compiler_digest.encode())
+        for name in sorted(seen):
+            digest.update(f"{name}:{by_name[name].mvid}\n".encode())
+
+        keys[assembly.path] = digest.hexdigest()
+
+    return keys
+
+
+def object_path(args, assembly):
+    directory = args.output_dir or os.path.dirname(assembly.path)
+    return os.path.join(directory, os.path.basename(assembly.path) + ".o")
+
+
+SHF_EXECINSTR = 0x4
+
+
+# Size of the executable sections of an ELF64 object file
+def text_size(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:4] != b"\x7fELF" or data[4] != 2:
+        raise ValueError(f"{path} is not a 64 bit ELF object")
+
+    section_offset, = struct.unpack_from("<Q", data, 0x28)
+    section_size, section_count = struct.unpack_from("<HH", data, 0x3A)
+
+    total = 0
+    for i in range(section_count):
+        header = section_offset + i * section_size
+        flags, = struct.unpack_from("<Q", data, header + 8)
+        size, = struct.unpack_from("<Q", data, header + 32)
+        if flags & SHF_EXECINSTR:
+            total += size
+    return total
+
+
+def compile_assembly(args, assemblies, assembly, key):
+    output = object_path(args, assembly)
+    cached_object = os.path.join(args.cache, key + ".o")
+    cached_log = os.path.join(args.cache, key + ".log")
+
+    start = time.monotonic()
+
+    if os.path.exists(cached_object) and os.path.exists(cached_log):
+        shutil.copyfile(cached_object, output)
+        with open(cached_log) as f:
+            log = f.read()
+        return {"name": assembly.name, "key": key, "cached": True, "seconds": time.monotonic() - start, "text_bytes": text_size(output), "log": log}
+
+    inputs = [assembly.path]
+    if is_dedup(args, assembly):
+        # The compiler collects the instances from the other assemblies and only emits the dedup module, which has to come last
+        inputs = [a.path for a in assemblies if a is not assembly] + inputs
+
+    command = [args.compiler, f"--path={args.path}", f"--aot={assembly_options(args, assembly)},outfile={output}"] + inputs
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    elapsed = time.monotonic() - start
+
+    if result.returncode != 0:
+        raise RuntimeError(f"mono-aot-cross failed for {assembly.name} with code {result.returncode}:\n{result.stdout}")
+
+    # Write to temporary names first so an interrupted build never leaves half written cache entries
+    shutil.copyfile(output, cached_object + ".tmp")
+    with open(cached_log + ".tmp", "w") as f:
+        f.write(result.stdout)
+    os.replace(cached_object + ".tmp", cached_object)
+    os.replace(cached_log + ".tmp", cached_log)
+
+    return {"name": assembly.name, "key": key, "cached": False, "seconds": elapsed, "text_bytes": text_size(output), "log": result.stdout}
+
+
+LINKING_SYMBOL = re.compile(r"Linking symbol: '([^']*)'\.")
+
+
+def module_symbol_name(assembly):
+    return "mono_aot_module_" + re.sub(r"[^A-Za-z0-9]", "_", assembly.name) + "_info"
+
+
+def write_registrations(args, assemblies, results):
+    modules = []
+    for assembly in assemblies:
+        symbols = LINKING_SYMBOL.findall(results[assembly.path]["log"])
+        if is_dedup(args, assembly):
+            # The dedup compilation also goes through the other assemblies, only keep its own module
+            symbols = [s for s in symbols if s == module_symbol_name(assembly)]
+        if len(symbols) != 1:
+            print(f"Expected one module symbol for {assembly.name} but the compiler reported {len(symbols)}", file=sys.stderr)
+            return False
+        modules.append((assembly, symbols[0]))
+
+    with open(args.modules_header, "w") as f:
+        f.write("// Generated by aot_compile.py, do not edit\n")
+        f.write("// Each line registers one of the object files listed in " + os.path.basename(args.link_list) + "\n")
+        for assembly, symbol in modules:
+            f.write(f"STATIC_MONO_SYM({symbol}); // {assembly.name}\n")
+
+    # Makefile fragment, names are relative to the folder of the object files
+    with open(args.link_list, "w") as f:
+        f.write("# Generated by aot_compile.py, do not edit\n")
+        f.write("AOT_OBJECTS := \\\n")
+        for assembly, _ in modules:
+            f.write(f"\t{os.path.basename(object_path(args, assembly))} \\\n")
+        f.write("\n")
+
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Parallel and cached mono AOT compilation")
+    parser.add_argument("--compiler", required=True, help="path of mono-aot-cross")
+    parser.add_argument("--options", required=True, help="--aot options, outfile is added for each assembly")
+    parser.add_argument("--path", required=True, help="assembly search path passed to the compiler")
+    parser.add_argument("--cache", default="aot_cache", help="folder that holds the cached object files")
+    parser.add_argument("--log", required=True, help="compiler output of every assembly is concatenated here")
+    parser.add_argument("--report", required=True, help="json file with the time taken by each assembly")
+    parser.add_argument("--output-dir", help="folder for the object files, by default they're next to each assembly")
+    parser.add_argument("--modules-header", required=True, help="generated header with a STATIC_MONO_SYM line for each module")
+    parser.add_argument("--link-list", required=True, help="generated makefile fragment that sets AOT_OBJECTS")
+    parser.add_argument("--dedup", help="assembly that receives the generic instances shared by the other modules, must be one of the assemblies")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(), help="number of parallel compilers")
+    parser.add_argument("assemblies", nargs="+")
+    args = parser.parse_args()
+
+    os.makedirs(args.cache, exist_ok=True)
+    if args.output_dir:
+        os.makedirs(args.output_dir, exist_ok=True)
+
+    total_start = time.monotonic()
+
+    assemblies = [read_assembly_info(path) for path in args.assemblies]
+    if args.dedup is not None and not any(is_dedup(args, a) for a in assemblies):
+        print(f"The dedup assembly {args.dedup} is not in the list of assemblies", file=sys.stderr)
+        return 1
+
+    keys = compute_keys(args, assemblies, file_digest(args.compiler))
+
+    # Start the largest assemblies first, CoreLib alone takes longer than most of the others combined
+    # The dedup module compiles everything so it goes before anything else
+    order = sorted(assemblies, key=lambda a: (is_dedup(args, a), os.path.getsize(a.path)), reverse=True)
+
+    results = {}
+    failed = False
+    with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        futures = {pool.submit(compile_assembly, args, assemblies, a, keys[a.path]): a for a in order}
+        for future in concurrent.futures.as_completed(futures):
+            assembly = futures[future]
+            try:
+                result = future.result()
+            except Exception as e:
+                print(e, file=sys.stderr)
+                failed = True
+                continue
+
+            results[assembly.path] = result
+            state = "cached" if result["cached"] else f"{result['seconds']:.1f}s"
+            print(f"  {assembly.name}: {state}")
+
+    if failed:
+        return 1
+
+    if not write_registrations(args, assemblies, results):
+        return 1
+
+    # Keep the log in command line order so the output doesn't change between runs
+    with open(args.log, "w") as f:
+        for path in args.assemblies:
+            f.write(results[path].pop("log"))
+
+    report = {
+        "jobs": args.jobs,
+        "total_seconds": time.monotonic() - total_start,
+        "compiled": sum(1 for r in results.values() if not r["cached"]),
+        "cached": sum(1 for r in results.values() if r["cached"]),
+        "dedup": args.dedup is not None,
+        "text_bytes": sum(r["text_bytes"] for r in results.values()),
+        "assemblies": [results[path] for path in args.assemblies],
+    }
+
+    with open(args.report, "w") as f:
+        json.dump(report, f, indent=2)
+
+    print(f"AOT: {report['compiled']} compiled, {report['cached']} from cache in {report['total_seconds']:.1f}s, {report['text_bytes'] / (1024 * 1024):.1f}MB of code")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
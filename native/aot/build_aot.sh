@@ -13,43 +13,102 @@ if ! which dotnet >/dev/null 2>&1; then
     fi
 fi
 
-if [ -d output ]; then
-    rm -rf output/
+# AOT_BACKEND=llvm compiles with mono's LLVM backend into output_llvm/, build the nro with make AOT_BACKEND=llvm
+# This needs a cross compiler built with LLVM support (MONO_NX_LLVM=1 ./build_mono.sh) and MONO_LLVM_PATH set to the folder with opt and llc
+AOT_BACKEND=${AOT_BACKEND:-mini}
+
+# AOT_PROJECT selects another project to compile, for example ../../managed/benchmark/benchmark.csproj
+AOT_PROJECT=${AOT_PROJECT:-managed/program.csproj}
+AOT_MAIN=$(basename $AOT_PROJECT .csproj)
+
+case $AOT_BACKEND in
+    mini)
+        OUTPUT=output
+        AOT_OPTIONS=full,static,tool-prefix=aarch64-none-elf-
+        ;;
+    llvm)
+        if [ ! -x "$MONO_LLVM_PATH/llc" ]; then
+            echo "MONO_LLVM_PATH must point to the folder that contains opt and llc"
+            exit 1
+        fi
+        OUTPUT=output_llvm
+        AOT_OPTIONS=full,static,llvm,llvm-path=$MONO_LLVM_PATH,tool-prefix=aarch64-none-elf-
+        ;;
+    *)
+        echo "Unknown AOT_BACKEND $AOT_BACKEND, use mini or llvm"
+        exit 1
+        ;;
+esac
+
+# MONO_NX_CONFIG=Release compiles against the Release mono build into <output>_release/, build the nro with make MONO_NX_CONFIG=Release
+# The images must be compiled by the same mono build that runs them, see notes/release_build.md
+MONO_NX_CONFIG=${MONO_NX_CONFIG:-Debug}
+
+# AOT_DEDUP=1 compiles the generic instances shared between assemblies once, in aot-instances.dll.o, instead of in every module.
+# It builds into <output>_dedup/ so the size can be compared with compare_backends.py, build the nro with make AOT_DEDUP=1
+if [ "$AOT_DEDUP" = "1" ]; then
+    OUTPUT=${OUTPUT}_dedup
+fi
+
+if [ "$MONO_NX_CONFIG" = "Release" ]; then
+    OUTPUT=${OUTPUT}_release
+fi
+
+if [ -d $OUTPUT ]; then
+    rm -rf $OUTPUT/
 fi
 
 echo Building the project...
-dotnet build managed/program.csproj 
+dotnet build $AOT_PROJECT
+
+ILLINK_ROOTS="-a $(dirname $AOT_PROJECT)/bin/Debug/net9.0/$AOT_MAIN.dll"
+if [ "$AOT_DEDUP" = "1" ]; then
+    # Empty assembly that owns the shared instances, mono loads it at runtime so it must be in the romfs like the others
+    dotnet build aot_instances/aot-instances.csproj
+    ILLINK_ROOTS="$ILLINK_ROOTS -a aot_instances/bin/Debug/net9.0/aot-instances.dll"
+    AOT_DEDUP_ARGS="--dedup $OUTPUT/aot-instances.dll"
+fi
 
 echo Trimming the assemblies...
 
-ILLINK=$MONO_NX_ROOT/artifacts/bin/Mono.Linker/Debug/net9.0/illink.dll
+ILLINK=$MONO_NX_ROOT/artifacts/bin/Mono.Linker/$MONO_NX_CONFIG/net9.0/illink.dll
 ILLINK_CFG=$MONO_NX_ROOT/src/mono/System.Private.CoreLib/src/ILLink/ILLink.Descriptors.xml
 ILLINK_CFG1=$MONO_NX_ROOT/src/mono/System.Private.CoreLib/src/ILLink/ILLink.LinkAttributes.xml
 
-LIB_ROOT=$MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.Debug/
-FRAMEWORK_ROOT=$MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-Debug-arm64/
+LIB_ROOT=$MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.$MONO_NX_CONFIG/
+FRAMEWORK_ROOT=$MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-$MONO_NX_CONFIG-arm64/
 
-dotnet $ILLINK -x $ILLINK_CFG -x $ILLINK_CFG1 --feature System.Resources.UseSystemResourceKeys true -d $LIB_ROOT -d $FRAMEWORK_ROOT --trim-mode link -a managed/bin/Debug/net9.0/program.dll
+# --deterministic keeps the MVID of unchanged assemblies stable so aot_compile.py can reuse their object files
+dotnet $ILLINK -x $ILLINK_CFG -x $ILLINK_CFG1 --feature System.Resources.UseSystemResourceKeys true --deterministic -d $LIB_ROOT -d $FRAMEWORK_ROOT --trim-mode link -out $OUTPUT $ILLINK_ROOTS
 
 echo Mono AOT build...
 
-MONO_COMPILER=$MONO_NX_ROOT/artifacts/bin/mono/linux.x64.Debug/cross/linux-x64/libnx-arm64/mono-aot-cross
+MONO_COMPILER=$MONO_NX_ROOT/artifacts/bin/mono/linux.x64.$MONO_NX_CONFIG/cross/linux-x64/libnx-arm64/mono-aot-cross
 
 export PATH=$PATH:$DEVKITPRO/devkitA64/bin/
 
-echo "build log" > mono_aot.log
+# Assemblies are compiled in parallel and the object files are cached in aot_cache/, see aot_compile.py for how changes are detected.
+# The time taken by each assembly and the size of its code is written to aot_report.json
+# aot_modules.h registers the modules in source/main.c and aot_modules.mk lists the objects the Makefile links
+# TODO: try the direct-pinvoke option here to reduce the need for the dlshim
+python3 aot_compile.py --compiler $MONO_COMPILER --path=$OUTPUT/ --options $AOT_OPTIONS \
+    --cache aot_cache --log $OUTPUT/mono_aot.log --report $OUTPUT/aot_report.json -j ${AOT_JOBS:-$(nproc)} \
+    --modules-header $OUTPUT/aot_modules.h --link-list $OUTPUT/aot_modules.mk $AOT_DEDUP_ARGS $OUTPUT/*.dll
 
-for file in output/*.dll; do
-    # TODO: try the direct-pinvoke option here to reduce the need for the dlshim
-    $MONO_COMPILER --path=output/ --aot=full,static,tool-prefix=aarch64-none-elf- $file >> mono_aot.log
-done
+# Entry point used when aot_config.ini doesn't set default_assembly
+echo "#define AOT_MAIN_ASSEMBLY \"/$AOT_MAIN.dll\"" > $OUTPUT/aot_main.h
 
 echo copying outputs
+# Every output has its own romfs so the dlls always match the objects the Makefile links from it, romfs/ only holds the files all of them share
+ROMFS=$OUTPUT/romfs
+mkdir -p $ROMFS
+cp -r romfs/. $ROMFS/
+
 # Dlls are needed for metadata
-cp output/*.dll romfs/
+cp $OUTPUT/*.dll $ROMFS/
 
 echo copying full icu data file
-cp $ICU_NX_INSTALL_DIR/share/icu/77.1/icudt77l.dat romfs/
+cp $ICU_NX_INSTALL_DIR/share/icu/77.1/icudt77l.dat $ROMFS/
 
-echo Static-linking symbols:
-grep -r "Linking symbol:" mono_aot.log | sed "s/Linking symbol: '\([^']*\)'\./STATIC_MONO_SYM(\1);/"
+echo Registered modules:
+cat $OUTPUT/aot_modules.h
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+
+# Compares two AOT builds of the same project, by default the mini backend in output/ against the LLVM backend in output_llvm/
+# It works for any pair of output folders, for example output/ and output_dedup/ to measure AOT_DEDUP=1
+# Code size is the size of the executable sections of each object file.
+# Speedup is computed from the RESULT lines printed by managed/benchmark, pass the logs of a run of each nro.
+
+import argparse
+import glob
+import json
+import os
+import re
+import sys
+
+from aot_compile import text_size
+
+RESULT_LINE = re.compile(r"RESULT (\S+) (\S+) ([0-9.eE+-]+) (\S+)")
+
+# Units where a smaller value is better, everything else is treated as a rate
+TIME_UNITS = {"s", "ms", "us", "ns"}
+
+
+def object_sizes(folder):
+    return {os.path.basename(p): text_size(p) for p in sorted(glob.glob(os.path.join(folder, "*.o")))}
+
+
+def read_results(path):
+    results = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            match = RESULT_LINE.search(line)
+            if match:
+                name, metric, value, unit = match.groups()
+                results[(name, metric)] = (float(value), unit)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare code size and benchmark results of two AOT backends")
+    parser.add_argument("--baseline", default="output", help="object files of the reference build")
+    parser.add_argument("--candidate", default="output_llvm", help="object files of the build being evaluated")
+    parser.add_argument("--baseline-log", help="benchmark log from the reference nro")
+    parser.add_argument("--candidate-log", help="benchmark log from the nro being evaluated")
+    parser.add_argument("--json", help="also write the comparison to this file")
+    args = parser.parse_args()
+
+    report = {"code_size": [], "benchmarks": []}
+
+    baseline = object_sizes(args.baseline)
+    candidate = object_sizes(args.candidate)
+
+    print(f"{'object':48} {'baseline KB':>12} {'candidate KB':>12} {'ratio':>7}")
+    for name in sorted(set(baseline) | set(candidate)):
+        base, cand = baseline.get(name), candidate.get(name)
+        ratio = cand / base if base and cand else None
+        print(f"{name:48} {(base or 0) / 1024:12.1f} {(cand or 0) / 1024:12.1f} {ratio if ratio else float('nan'):7.2f}")
+        report["code_size"].append({"object": name, "baseline": base, "candidate": cand})
+
+    base_total, cand_total = sum(baseline.values()), sum(candidate.values())
+    print(f"{'total':48} {base_total / 1024:12.1f} {cand_total / 1024:12.1f} {cand_total / base_total if base_total else float('nan'):7.2f}")
+
+    if args.baseline_log and args.candidate_log:
+        base_results = read_results(args.baseline_log)
+        cand_results = read_results(args.candidate_log)
+
+        print()
+        print(f"{'benchmark':48} {'baseline':>12} {'candidate':>12} {'speedup':>7}")
+        for key in sorted(set(base_results) & set(cand_results)):
+            (base, unit), (cand, _) = base_results[key], cand_results[key]
+            if not base or not cand:
+                continue
+
+            speedup = base / cand if unit in TIME_UNITS else cand / base
+            name = f"{key[0]} {key[1]}"
+            print(f"{name:48} {base:12.3f} {cand:12.3f} {speedup:7.2f}")
+            report["benchmarks"].append({"name": key[0], "metric": key[1], "unit": unit, "baseline": base, "candidate": cand, "speedup": speedup})
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
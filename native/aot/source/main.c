@@ -1,6 +1,9 @@
 #include "core.h"
 #include <unistd.h>
 
+// Generated by build_aot.sh, defines AOT_MAIN_ASSEMBLY
+#include "aot_main.h"
+
 #define STATIC_MONO_SYM(x) do {\
     extern void* x; \
     mono_aot_register_module(x);\
@@ -21,17 +24,11 @@ int main(int argc, char *argv[])
 
     MonoDomain *domain = NULL;
     
-    // Output from build_aot.sh
-    STATIC_MONO_SYM(mono_aot_module_System_Collections_Concurrent_info);
-    STATIC_MONO_SYM(mono_aot_module_System_Console_info);
-    STATIC_MONO_SYM(mono_aot_module_System_Diagnostics_DiagnosticSource_info);
-    STATIC_MONO_SYM(mono_aot_module_System_Private_CoreLib_info);
-    STATIC_MONO_SYM(mono_aot_module_System_Runtime_Serialization_Formatters_info);
-    STATIC_MONO_SYM(mono_aot_module_System_Runtime_info);
-    STATIC_MONO_SYM(mono_aot_module_System_Threading_Thread_info);
-    STATIC_MONO_SYM(mono_aot_module_program_info);
+    // Generated by build_aot.sh, the Makefile links exactly the objects these symbols come from
+    #include "aot_modules.h"
 
     mono_jit_set_aot_mode(MONO_AOT_MODE_FULL);
+    application_set_execution_mode("aot");
 
     application_configure_mono();
 
@@ -42,16 +39,25 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    io_debugf("Loading assembly %s", g_config.default_assembly);
+    profiler_mark("mono_jit_init");
+    thread_stacks_runtime_started();
+
+    // The config can still override the assembly that build_aot.sh compiled as the entry point
+    char *main_assembly = g_config.default_assembly ? g_config.default_assembly : AOT_MAIN_ASSEMBLY;
 
-    MonoAssembly *assembly = mono_domain_assembly_open(domain, g_config.default_assembly);
+    io_debugf("Loading assembly %s", main_assembly);
+
+    MonoAssembly *assembly = mono_domain_assembly_open(domain, main_assembly);
     if (!assembly)
     {
         fatal_error("Failed to load assembly");
         return 1;
     }
 
-    char *monoargs[] = {g_config.default_assembly};
+    profiler_mark("assembly loaded");
+    profiler_report();
+
+    char *monoargs[] = {main_assembly};
 
     mono_jit_exec(domain, assembly, 1, monoargs);
 
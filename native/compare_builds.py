@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+
+# Compares the Debug and Release flavours of a launcher, see notes/release_build.md for how to collect the logs
+# Binary size is the size of the nro and of the executable sections of the elf the nro was made from.
+# Startup is parsed from the profiler report printed with startup_profile=true, throughput from the RESULT lines of managed/benchmark.
+# Each flavour can be given several logs, the median of every value is compared so a single noisy run doesn't skew the result.
+
+import argparse
+import json
+import os
+import re
+import statistics
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "aot"))
+from aot_compile import text_size
+
+RESULT_LINE = re.compile(r"RESULT (\S+) (\S+) ([0-9.eE+-]+) (\S+)")
+# Printed by profiler_report() as "%-32s %8llu us (+%llu us)"
+MARK_LINE = re.compile(r"^(\S.*?)\s+(\d+) us \(\+\d+ us\)\s*$")
+
+# Units where a smaller value is better, everything else is treated as a rate
+TIME_UNITS = {"s", "ms", "us", "ns"}
+
+
+def read_log(path):
+    marks, results = {}, {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            match = MARK_LINE.match(line)
+            if match:
+                marks[match.group(1)] = float(match.group(2))
+                continue
+
+            match = RESULT_LINE.search(line)
+            if match:
+                name, metric, value, unit = match.groups()
+                results[(name, metric)] = (float(value), unit)
+    return marks, results
+
+
+def median_logs(paths):
+    marks, results, units = {}, {}, {}
+    for path in paths:
+        log_marks, log_results = read_log(path)
+        for name, value in log_marks.items():
+            marks.setdefault(name, []).append(value)
+        for key, (value, unit) in log_results.items():
+            results.setdefault(key, []).append(value)
+            units[key] = unit
+
+    return ({k: statistics.median(v) for k, v in marks.items()},
+            {k: (statistics.median(v), units[k]) for k, v in results.items()})
+
+
+def binary_sizes(elf):
+    sizes = {}
+    nro = os.path.splitext(elf)[0] + ".nro"
+    if os.path.exists(nro):
+        sizes["nro"] = os.path.getsize(nro)
+    if os.path.exists(elf):
+        sizes["elf text"] = text_size(elf)
+    return sizes
+
+
+def ratio(base, cand):
+    return cand / base if base and cand else float("nan")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare binary size, startup time and benchmark results of two builds")
+    parser.add_argument("--baseline", default="interpreter/mono_nx.elf", help="elf of the reference build, the nro is expected next to it")
+    parser.add_argument("--candidate", default="interpreter/mono_nx_release.elf", help="elf of the build being evaluated")
+    parser.add_argument("--baseline-log", nargs="*", default=[], help="logs of the reference nro, one per run")
+    parser.add_argument("--candidate-log", nargs="*", default=[], help="logs of the nro being evaluated, one per run")
+    parser.add_argument("--json", help="also write the comparison to this file")
+    args = parser.parse_args()
+
+    report = {"size": [], "startup": [], "benchmarks": []}
+
+    base_sizes, cand_sizes = binary_sizes(args.baseline), binary_sizes(args.candidate)
+    print(f"{'binary':48} {'baseline KB':>12} {'candidate KB':>12} {'ratio':>7}")
+    for name in ("nro", "elf text"):
+        base, cand = base_sizes.get(name), cand_sizes.get(name)
+        if base is None and cand is None:
+            continue
+        print(f"{name:48} {(base or 0) / 1024:12.1f} {(cand or 0) / 1024:12.1f} {ratio(base, cand):7.2f}")
+        report["size"].append({"name": name, "baseline": base, "candidate": cand})
+
+    if args.baseline_log and args.candidate_log:
+        base_marks, base_results = median_logs(args.baseline_log)
+        cand_marks, cand_results = median_logs(args.candidate_log)
+
+        # Marks are printed in the order they were taken, keep that order instead of sorting
+        names = [name for name in base_marks if name in cand_marks]
+        if names:
+            print()
+            print(f"{'startup mark (us since start)':48} {'baseline':>12} {'candidate':>12} {'ratio':>7}")
+            for name in names:
+                base, cand = base_marks[name], cand_marks[name]
+                print(f"{name:48} {base:12.0f} {cand:12.0f} {ratio(base, cand):7.2f}")
+                report["startup"].append({"mark": name, "baseline": base, "candidate": cand})
+
+        print()
+        print(f"{'benchmark':48} {'baseline':>12} {'candidate':>12} {'speedup':>7}")
+        for key in sorted(set(base_results) & set(cand_results)):
+            (base, unit), (cand, _) = base_results[key], cand_results[key]
+            if not base or not cand:
+                continue
+
+            speedup = base / cand if unit in TIME_UNITS else cand / base
+            name = f"{key[0]} {key[1]}"
+            print(f"{name:48} {base:12.3f} {cand:12.3f} {speedup:7.2f}")
+            report["benchmarks"].append({"name": key[0], "metric": key[1], "unit": unit, "baseline": base, "candidate": cand, "speedup": speedup})
+
+        print()
+        print(f"runs: {len(args.baseline_log)} baseline, {len(args.candidate_log)} candidate, values are medians")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,50 @@
+#!/bin/sh
+
+# AOT compiles the framework assemblies for the mixed mode build of mono_nx (make MIXED=1)
+# Only the assemblies listed in framework_aot.txt are compiled, everything else including the app itself stays interpreted.
+# The images are only used when the dll on the sd card is the exact same build, so run copy_sd_files.sh from the same mono build.
+
+# MONO_NX_CONFIG=Release compiles the Release framework into framework_aot_release/ for make MIXED=1 MONO_NX_CONFIG=Release
+
+set -e
+
+MONO_NX_CONFIG=${MONO_NX_CONFIG:-Debug}
+
+LIB_ROOT=$MONO_NX_ROOT/artifacts/bin/mono/libnx.arm64.$MONO_NX_CONFIG/
+FRAMEWORK_ROOT=$MONO_NX_ROOT/artifacts/bin/runtime/net9.0-libnx-$MONO_NX_CONFIG-arm64/
+
+MONO_COMPILER=$MONO_NX_ROOT/artifacts/bin/mono/linux.x64.$MONO_NX_CONFIG/cross/linux-x64/libnx-arm64/mono-aot-cross
+
+OUTPUT=framework_aot
+if [ "$MONO_NX_CONFIG" = "Release" ]; then
+    OUTPUT=framework_aot_release
+fi
+
+export PATH=$PATH:$DEVKITPRO/devkitA64/bin/
+
+if [ -d $OUTPUT ]; then
+    rm -rf $OUTPUT/
+fi
+
+mkdir -p $OUTPUT
+
+ASSEMBLIES=""
+for name in $(grep -v '^#' framework_aot.txt); do
+    if [ -f $LIB_ROOT/$name.dll ]; then
+        ASSEMBLIES="$ASSEMBLIES $LIB_ROOT/$name.dll"
+    elif [ -f $FRAMEWORK_ROOT/$name.dll ]; then
+        ASSEMBLIES="$ASSEMBLIES $FRAMEWORK_ROOT/$name.dll"
+    else
+        echo "$name.dll was not found"
+        exit 1
+    fi
+done
+
+# Same parallel and cached compilation as the AOT example, see native/aot/aot_compile.py
+# interp generates the wrappers needed to call between interpreted and AOT code
+python3 ../aot/aot_compile.py --compiler $MONO_COMPILER --path=$LIB_ROOT:$FRAMEWORK_ROOT --options full,interp,static,tool-prefix=aarch64-none-elf- \
+    --cache aot_cache --log $OUTPUT/mono_aot.log --report $OUTPUT/aot_report.json -j ${AOT_JOBS:-$(nproc)} --output-dir $OUTPUT \
+    --modules-header $OUTPUT/framework_aot_modules.h --link-list $OUTPUT/aot_modules.mk $ASSEMBLIES
+
+echo "Registered modules:"
+cat $OUTPUT/framework_aot_modules.h
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+
+# Compares the [interp] options of config.ini on managed/benchmark, see notes/interpreter.md
+#
+# pack:   creates one bundle per option set, each with a config override that only changes the [interp] section
+# report: reads the logs of a run of each bundle and prints every benchmark relative to mono's defaults
+#         logs of other execution modes, like [jit] enabled = true, can be passed too and are labelled with the mode
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+INTERP_KEYS = ["inline", "cprop", "super_instructions", "bblocks", "tiering", "simd"]
+
+# Each set lists the options it turns off, everything else keeps mono's default
+OPTION_SETS = {
+    "default": [],
+    "no_tiering": ["tiering"],
+    "no_super": ["super_instructions"],
+    "no_inline": ["inline"],
+    "no_cprop": ["cprop"],
+    "no_simd": ["simd"],
+    "minimal": INTERP_KEYS,
+}
+
+RESULT_LINE = re.compile(r"RESULT (\S+) (\S+) ([0-9.eE+-]+) (\S+)")
+CONFIG_LINE = re.compile(r"CONFIG interp (\S+)")
+MODE_LINE = re.compile(r"CONFIG mode (\S+)")
+
+# Units where a smaller value is better, everything else is treated as a rate
+TIME_UNITS = {"s", "ms", "us", "ns"}
+
+
+def pack(args):
+    os.makedirs(args.output, exist_ok=True)
+    packer = os.path.join(os.path.dirname(os.path.abspath(__file__)), "pack_bundle.py")
+    name = os.path.splitext(os.path.basename(args.main))[0]
+
+    for set_name, disabled in OPTION_SETS.items():
+        config = os.path.join(args.output, f"{set_name}.ini")
+        with open(config, "w") as f:
+            f.write("[interp]\n")
+            for key in disabled:
+                f.write(f"{key} = false\n")
+
+        bundle = os.path.join(args.output, f"{name}_{set_name}.bundle")
+        subprocess.run([sys.executable, packer, "-o", bundle, "-m", args.main, "-c", config] + args.inputs, check=True)
+
+    print(f"Created {len(OPTION_SETS)} bundles in {args.output}, run each of them and save the logs")
+    return 0
+
+
+def read_log(path):
+    label = os.path.splitext(os.path.basename(path))[0]
+    mode = "interpreter"
+    results = {}
+    failed = False
+    done = False
+
+    with open(path, errors="replace") as f:
+        for line in f:
+            if match := MODE_LINE.search(line):
+                mode = match.group(1)
+            elif match := CONFIG_LINE.search(line):
+                label = match.group(1)
+            elif match := RESULT_LINE.search(line):
+                name, metric, value, unit = match.groups()
+                results[(name, metric)] = (float(value), unit)
+            elif " failed: " in line:
+                failed = True
+            elif "DONE !" in line:
+                done = True
+
+    if mode != "interpreter":
+        label = mode if label == "default" else f"{mode}:{label}"
+
+    # A set that breaks any benchmark is not safe to use even if it's faster
+    return label, results, failed or not done
+
+
+def report(args):
+    runs = [read_log(path) for path in args.logs]
+    baseline = next((r for r in runs if r[0] == "default"), runs[0])
+
+    labels = [label for label, _, _ in runs]
+    width = max(12, *(len(label) for label in labels))
+
+    print(f"{'benchmark':40} " + " ".join(f"{label:>{width}}" for label in labels))
+    for key in sorted(baseline[1]):
+        base, unit = baseline[1][key]
+        cells = []
+        for _, results, _ in runs:
+            value = results.get(key)
+            if not value or not base or not value[0]:
+                cells.append(f"{'-':>{width}}")
+                continue
+            ratio = base / value[0] if unit in TIME_UNITS else value[0] / base
+            cells.append(f"{ratio:>{width}.2f}")
+        print(f"{key[0] + ' ' + key[1]:40} " + " ".join(cells))
+
+    print(f"{'safe':40} " + " ".join(f"{'no' if unsafe else 'yes':>{width}}" for _, _, unsafe in runs))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark the interpreter options")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    pack_parser = commands.add_parser("pack", help="create one bundle per option set")
+    pack_parser.add_argument("-o", "--output", required=True, help="folder for the bundles")
+    pack_parser.add_argument("-m", "--main", required=True, help="benchmark.dll, trimmed like in notes/bundle.md")
+    pack_parser.add_argument("inputs", nargs="*", help="framework assemblies or folders passed to pack_bundle.py")
+
+    report_parser = commands.add_parser("report", help="compare the logs of each bundle, values are relative to the default set")
+    report_parser.add_argument("logs", nargs="+")
+
+    args = parser.parse_args()
+    return pack(args) if args.command == "pack" else report(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
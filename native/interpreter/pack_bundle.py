@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+
+# Packs an application and its framework assemblies in a single .bundle file for mono_nx.nro
+# The format is described in notes/bundle.md and must match native/shared/bundle.h
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"MNXB"
+VERSION = 1
+
+KIND_ASSEMBLY = 0
+KIND_MAIN_ASSEMBLY = 1
+KIND_CONFIG = 2
+
+HEADER_FORMAT = "<4sIII"
+ENTRY_FORMAT = "<IIQQ"
+DATA_ALIGNMENT = 16
+
+
+def align(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+
+def collect_assemblies(inputs):
+    files = {}
+    for path in inputs:
+        if os.path.isdir(path):
+            for name in sorted(os.listdir(path)):
+                if name.endswith(".dll"):
+                    files.setdefault(name, os.path.join(path, name))
+        else:
+            files.setdefault(os.path.basename(path), path)
+    return files
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Create a mono-nx assembly bundle")
+    parser.add_argument("-o", "--output", required=True, help="output .bundle file")
+    parser.add_argument("-m", "--main", required=True, help="entry point assembly")
+    parser.add_argument("-c", "--config", help="optional ini file that overrides config.ini for this app")
+    parser.add_argument("inputs", nargs="*", help="assemblies or folders of assemblies to include, the first occurrence of a name wins")
+    args = parser.parse_args()
+
+    main_name = os.path.basename(args.main)
+    assemblies = collect_assemblies(args.inputs)
+    assemblies.pop(main_name, None)
+
+    # Entries are (kind, name, path), the main assembly goes first
+    entries = [(KIND_MAIN_ASSEMBLY, main_name, args.main)]
+    entries += [(KIND_ASSEMBLY, name, path) for name, path in sorted(assemblies.items())]
+    if args.config:
+        entries.append((KIND_CONFIG, os.path.basename(args.config), args.config))
+
+    strings = bytearray()
+    name_offsets = []
+    for _, name, _ in entries:
+        name_offsets.append(len(strings))
+        strings += name.encode("utf-8") + b"\0"
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    index_size = len(entries) * struct.calcsize(ENTRY_FORMAT) + len(strings)
+
+    # Lay out the data after the index
+    offset = align(header_size + index_size, DATA_ALIGNMENT)
+    layout = []
+    for kind, name, path in entries:
+        size = os.path.getsize(path)
+        layout.append((offset, size))
+        offset = align(offset + size, DATA_ALIGNMENT)
+
+    with open(args.output, "wb") as out:
+        out.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(entries), index_size))
+
+        for (kind, _, _), name_offset, (data_offset, size) in zip(entries, name_offsets, layout):
+            out.write(struct.pack(ENTRY_FORMAT, kind, name_offset, data_offset, size))
+
+        out.write(strings)
+
+        for (_, name, path), (data_offset, size) in zip(entries, layout):
+            out.write(b"\0" * (data_offset - out.tell()))
+            with open(path, "rb") as f:
+                out.write(f.read())
+
+    total = os.path.getsize(args.output)
+    print(f"Wrote {args.output}: {len(entries)} entries, {total // 1024} KB")
+    for kind, name, _ in entries:
+        label = {KIND_ASSEMBLY: "assembly", KIND_MAIN_ASSEMBLY: "main", KIND_CONFIG: "config"}[kind]
+        print(f"  {label:8} {name}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,5 +1,18 @@
 #include "core.h"
 
+#ifdef MONO_NX_MIXED_MODE
+#define STATIC_MONO_SYM(x) do {\
+    extern void* x; \
+    mono_aot_register_module(x);\
+} while(0)
+
+static void register_framework_aot()
+{
+    // Output from build_framework_aot.sh
+    #include "framework_aot_modules.h"
+}
+#endif
+
 int main(int argc, char *argv[])
 {
     // Needed when using minimal ICU data to reduce the size of the binary.
@@ -10,7 +23,53 @@ int main(int argc, char *argv[])
 
     MonoDomain *domain = NULL;
 
-    mono_jit_set_aot_mode(MONO_AOT_MODE_INTERP_ONLY);
+    char *launch_dll = io_strdup(argc > 1 ? argv[1] : g_config.default_assembly);
+    if (!launch_dll)
+    {
+        fatal_error("No .dll was specified");
+        return 1;
+    }
+
+    // Bundles must be registered before mono_jit_init so corlib can be found in them
+    const char *assembly_name = launch_dll;
+    if (bundle_is_bundle_path(launch_dll))
+    {
+        if (!bundle_load(launch_dll))
+        {
+            fatal_error("Failed to load bundle");
+            return 1;
+        }
+
+        if (bundle_config() && !application_apply_config_text(bundle_config()))
+        {
+            fatal_error("Failed to parse the bundle config");
+            return 1;
+        }
+
+        assembly_name = bundle_main_assembly();
+        profiler_mark("bundle loaded");
+    }
+
+#ifdef MONO_NX_MIXED_MODE
+    // Framework methods run from the static AOT images, anything that has no image (the app itself) is interpreted
+    register_framework_aot();
+    MonoAotMode interp_mode = MONO_AOT_MODE_INTERP;
+    application_set_execution_mode("mixed");
+#else
+    MonoAotMode interp_mode = MONO_AOT_MODE_INTERP_ONLY;
+#endif
+
+    // After the bundle so its config can pick the execution mode and the interpreter options for the app
+    if (g_config.jit_enabled && application_configure_jit())
+    {
+        // Anything without an AOT image is compiled to native code, see notes/jit.md
+        mono_jit_set_aot_mode(MONO_AOT_MODE_NORMAL);
+    }
+    else
+    {
+        application_configure_interpreter();
+        mono_jit_set_aot_mode(interp_mode);
+    }
 
     application_configure_mono();
 
@@ -21,29 +80,29 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    char *launch_dll = io_strdup(argc > 1 ? argv[1] : g_config.default_assembly);
-    if (!launch_dll)
-    {
-        fatal_error("No .dll was specified");
-        return 1;
-    }
+    profiler_mark("mono_jit_init");
+    thread_stacks_runtime_started();
 
-    io_debugf("Loading assembly %s", launch_dll);
+    io_debugf("Loading assembly %s", assembly_name);
     application_chdir_to_assembly(launch_dll);
 
-    MonoAssembly *assembly = mono_domain_assembly_open(domain, launch_dll);
+    MonoAssembly *assembly = mono_domain_assembly_open(domain, assembly_name);
     if (!assembly)
     {
         fatal_error("Failed to load assembly");
         return 1;
     }
 
+    profiler_mark("assembly loaded");
+    profiler_report();
+
     char *monoargs[] = {launch_dll};
 
     mono_jit_exec(domain, assembly, 1, monoargs);
 
     mono_jit_cleanup(domain);
 
+    bundle_free();
     free(launch_dll);
 
     application_terminate();
@@ -0,0 +1,156 @@
+#include "bundle.h"
+#include "io_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <mono/metadata/assembly.h>
+
+static uint8_t *bundle_data = NULL;
+static size_t bundle_size = 0;
+
+static MonoBundledAssembly *assemblies = NULL;
+static const MonoBundledAssembly **assembly_list = NULL;
+
+static const char *main_assembly = NULL;
+static char *config_text = NULL;
+
+bool bundle_is_bundle_path(const char *path)
+{
+    if (!path)
+        return false;
+
+    size_t len = strlen(path);
+    size_t ext_len = strlen(BUNDLE_EXTENSION);
+
+    return len > ext_len && strcmp(path + len - ext_len, BUNDLE_EXTENSION) == 0;
+}
+
+static bool validate_entry(const struct BundleEntry *entry, const char *strings, size_t strings_size)
+{
+    if (entry->name_offset >= strings_size)
+        return false;
+
+    // The name must be terminated inside the string table
+    if (!memchr(strings + entry->name_offset, '\0', strings_size - entry->name_offset))
+        return false;
+
+    if (entry->data_offset > bundle_size || entry->data_size > bundle_size - entry->data_offset)
+        return false;
+
+    return true;
+}
+
+bool bundle_load(const char *path)
+{
+    if (bundle_data)
+        return false;
+
+    if (!io_load_file(path, &bundle_data, &bundle_size))
+    {
+        io_debugf("Failed to read bundle %s", path);
+        return false;
+    }
+
+    const struct BundleHeader *header = (const struct BundleHeader *)bundle_data;
+    if (bundle_size < sizeof(*header) || memcmp(header->magic, BUNDLE_MAGIC, 4) != 0 || header->version != BUNDLE_VERSION)
+    {
+        io_debugf("%s is not a valid bundle", path);
+        goto error;
+    }
+
+    size_t entries_size = (size_t)header->entry_count * sizeof(struct BundleEntry);
+    if (header->index_size > bundle_size - sizeof(*header) || entries_size > header->index_size)
+    {
+        io_debugf("Bundle index is corrupted");
+        goto error;
+    }
+
+    const struct BundleEntry *entries = (const struct BundleEntry *)(bundle_data + sizeof(*header));
+    const char *strings = (const char *)entries + entries_size;
+    size_t strings_size = header->index_size - entries_size;
+
+    assemblies = calloc(header->entry_count, sizeof(MonoBundledAssembly));
+    assembly_list = calloc(header->entry_count + 1, sizeof(MonoBundledAssembly *));
+    if (!assemblies || !assembly_list)
+        goto error;
+
+    int count = 0;
+    for (uint32_t i = 0; i < header->entry_count; i++)
+    {
+        const struct BundleEntry *entry = &entries[i];
+        if (!validate_entry(entry, strings, strings_size))
+        {
+            io_debugf("Bundle entry %u is corrupted", i);
+            goto error;
+        }
+
+        const char *name = strings + entry->name_offset;
+        const uint8_t *data = bundle_data + entry->data_offset;
+
+        switch (entry->kind)
+        {
+        case BundleEntry_MainAssembly:
+            main_assembly = name;
+            // fallthrough
+        case BundleEntry_Assembly:
+            assemblies[count].name = name;
+            assemblies[count].data = data;
+            assemblies[count].size = (unsigned int)entry->data_size;
+            assembly_list[count] = &assemblies[count];
+            count++;
+            break;
+        case BundleEntry_Config:
+            config_text = malloc(entry->data_size + 1);
+            if (!config_text)
+                goto error;
+            memcpy(config_text, data, entry->data_size);
+            config_text[entry->data_size] = '\0';
+            break;
+        default:
+            io_debugf("Ignoring unknown bundle entry %s", name);
+            break;
+        }
+    }
+
+    if (!main_assembly)
+    {
+        io_debugf("The bundle has no main assembly");
+        goto error;
+    }
+
+    io_debugf("Loaded bundle %s: %d assemblies, %zu KB", path, count, bundle_size / 1024);
+
+    mono_register_bundled_assemblies(assembly_list);
+    return true;
+
+error:
+    bundle_free();
+    return false;
+}
+
+const char *bundle_main_assembly()
+{
+    return main_assembly;
+}
+
+const char *bundle_config()
+{
+    return config_text;
+}
+
+void bundle_free()
+{
+    // Mono keeps pointers to the assembly data until it shuts down, only call this after mono_jit_cleanup
+    free(assembly_list);
+    free(assemblies);
+    free(config_text);
+    free(bundle_data);
+
+    assembly_list = NULL;
+    assemblies = NULL;
+    config_text = NULL;
+    bundle_data = NULL;
+    bundle_size = 0;
+    main_assembly = NULL;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Single file assembly bundle produced by native/interpreter/pack_bundle.py, the format is described in notes/bundle.md
+// The whole file is loaded with a single read and the assemblies are registered with mono_register_bundled_assemblies so mono never probes the sd card for them.
+
+#define BUNDLE_MAGIC "MNXB"
+#define BUNDLE_VERSION 1
+#define BUNDLE_EXTENSION ".bundle"
+
+enum BundleEntryKind
+{
+    BundleEntry_Assembly = 0,
+    BundleEntry_MainAssembly = 1,
+    BundleEntry_Config = 2,
+};
+
+struct BundleHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    // Size of the entry table and the string table that follow the header
+    uint32_t index_size;
+};
+
+struct BundleEntry
+{
+    uint32_t kind;
+    // Offset of the zero terminated name in the string table
+    uint32_t name_offset;
+    // Offsets are from the start of the file
+    uint64_t data_offset;
+    uint64_t data_size;
+};
+
+bool bundle_is_bundle_path(const char *path);
+
+// Loads the bundle and registers its assemblies, must be called before mono_jit_init
+bool bundle_load(const char *path);
+
+// Name of the entry point assembly, pass this to mono_domain_assembly_open
+const char *bundle_main_assembly();
+
+// Optional ini text that overrides config.ini for this app, NULL if the bundle has none
+const char *bundle_config();
+
+void bundle_free();
@@ -1,5 +1,8 @@
 #include "core.h"
 #include "dl_shim.h"
+#include "dns_cache.h"
+#include "secure_random.h"
+#include "low_level_monitor.h"
 #include <unistd.h>
 #include <pthread.h>
 
@@ -7,29 +10,66 @@ static PadState pad;
 static bool using_console = false;
 
 static pthread_mutex_t sockets_mutex = PTHREAD_MUTEX_INITIALIZER;
-static volatile bool using_sockets = false;
+static bool using_sockets = false;
+
+// Overrides the libnx defaults with the [sockets] section. The bsd transfer memory is (tcp_tx_max + tcp_rx_max + udp_tx + udp_rx) * sb_efficiency
+static void socket_init_config(SocketInitConfig *config)
+{
+    *config = *socketGetDefaultInitConfig();
+
+    if (g_config.socket_tcp_tx_buf_kb > 0)
+        config->tcp_tx_buf_size = g_config.socket_tcp_tx_buf_kb * 1024;
+    if (g_config.socket_tcp_rx_buf_kb > 0)
+        config->tcp_rx_buf_size = g_config.socket_tcp_rx_buf_kb * 1024;
+    if (g_config.socket_tcp_tx_buf_max_kb > 0)
+        config->tcp_tx_buf_max_size = g_config.socket_tcp_tx_buf_max_kb * 1024;
+    if (g_config.socket_tcp_rx_buf_max_kb > 0)
+        config->tcp_rx_buf_max_size = g_config.socket_tcp_rx_buf_max_kb * 1024;
+    if (g_config.socket_udp_tx_buf_kb > 0)
+        config->udp_tx_buf_size = g_config.socket_udp_tx_buf_kb * 1024;
+    if (g_config.socket_udp_rx_buf_kb > 0)
+        config->udp_rx_buf_size = g_config.socket_udp_rx_buf_kb * 1024;
+    if (g_config.socket_sb_efficiency > 0)
+        config->sb_efficiency = g_config.socket_sb_efficiency;
+    if (g_config.socket_sessions > 0)
+        config->num_bsd_sessions = g_config.socket_sessions;
+
+    // The max sizes are upper bounds for the auto tuned buffers, they can't be smaller than the initial ones
+    if (config->tcp_tx_buf_max_size && config->tcp_tx_buf_max_size < config->tcp_tx_buf_size)
+        config->tcp_tx_buf_max_size = config->tcp_tx_buf_size;
+    if (config->tcp_rx_buf_max_size && config->tcp_rx_buf_max_size < config->tcp_rx_buf_size)
+        config->tcp_rx_buf_max_size = config->tcp_rx_buf_size;
+}
 
 void socket_esnure_init_thread_safe()
-{    
+{
+    // Called before every SystemNative_Socket, once initialized this is the only cost
+    if (__atomic_load_n(&using_sockets, __ATOMIC_ACQUIRE))
+        return;
+
     pthread_mutex_lock(&sockets_mutex);
     if (using_sockets) {
         pthread_mutex_unlock(&sockets_mutex);
         return;
     }
 
-    using_sockets = true;
+    SocketInitConfig config;
+    socket_init_config(&config);
 
-    io_debugf("Initializing sockets");
-    Result rc = socketInitializeDefault();
+    io_debugf("Initializing sockets: tcp %u/%u KB (max %u/%u KB) udp %u/%u KB sb_efficiency %u sessions %u",
+        config.tcp_tx_buf_size / 1024, config.tcp_rx_buf_size / 1024, config.tcp_tx_buf_max_size / 1024, config.tcp_rx_buf_max_size / 1024,
+        config.udp_tx_buf_size / 1024, config.udp_rx_buf_size / 1024, config.sb_efficiency, config.num_bsd_sessions);
+
+    Result rc = socketInitialize(&config);
     if (R_FAILED(rc))
     {
-        using_sockets = false;
         pthread_mutex_unlock(&sockets_mutex);
         io_debugf("Failed to init socketing: %08X", rc);
         fatal_error("failed to init socketing");
         return;
     }
 
+    __atomic_store_n(&using_sockets, true, __ATOMIC_RELEASE);
     pthread_mutex_unlock(&sockets_mutex);
 }
 
@@ -157,6 +197,66 @@ static char *inf_dup_unquote(const char *input)
     return res;
 }
 
+// Settings can be parsed more than once, see application_apply_config_text
+static void replace_string(char **field, const char *value)
+{
+    free(*field);
+    *field = inf_dup_unquote(value);
+}
+
+static const char *thread_kind_names[ThreadKind_Count] = { "main", "pool", "gc", "sockets" };
+static const char *thread_stack_kind_names[ThreadStackKind_Count] = { "managed", "pool", "gc", "native" };
+
+// [threads] options are <kind>_cores and <kind>_priority, <stack kind>_stack_kb, stack_report, native_monitor and monitor_spin
+static int handle_thread_policy_line(struct AppConfiguration *pconfig, const char *name, const char *value)
+{
+    if (strcmp(name, "stack_report") == 0)
+    {
+        pconfig->thread_stack_report = (strcmp(value, "true") == 0);
+        return 1;
+    }
+
+    if (strcmp(name, "native_monitor") == 0)
+    {
+        pconfig->native_monitor = (strcmp(value, "true") == 0);
+        return 1;
+    }
+
+    if (strcmp(name, "monitor_spin") == 0)
+    {
+        pconfig->monitor_spin = atoi(value);
+        return pconfig->monitor_spin >= 0;
+    }
+
+    for (int i = 0; i < ThreadStackKind_Count; i++)
+    {
+        size_t length = strlen(thread_stack_kind_names[i]);
+        if (strncmp(name, thread_stack_kind_names[i], length) == 0 && strcmp(name + length, "_stack_kb") == 0)
+        {
+            pconfig->thread_stack_kb[i] = atoi(value);
+            return pconfig->thread_stack_kb[i] >= 0;
+        }
+    }
+
+    for (int i = 0; i < ThreadKind_Count; i++)
+    {
+        size_t length = strlen(thread_kind_names[i]);
+        if (strncmp(name, thread_kind_names[i], length) || name[length] != '_')
+            continue;
+
+        const char *option = name + length + 1;
+        if (strcmp(option, "cores") == 0)
+            return thread_policy_parse_cores(value, &pconfig->threads[i].core_mask);
+        else if (strcmp(option, "priority") == 0)
+        {
+            pconfig->threads[i].priority = (int)strtol(value, NULL, 0);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 static int handle_ini_line(void *user, const char *section, const char *name, const char *value)
 {
     struct AppConfiguration *pconfig = (struct AppConfiguration *)user;
@@ -168,23 +268,83 @@ static int handle_ini_line(void *user, const char *section, const char *name, co
     if (MATCH("mono", "logging"))
         pconfig->mononx_logging = (strcmp(value, "true") == 0);
     else if (MATCH("mono", "icu"))
-        pconfig->icudata_path = inf_dup_unquote(value);
+        replace_string(&pconfig->icudata_path, value);
     else if (MATCH("mono", "assembly_dir"))
-        pconfig->assembly_dir = inf_dup_unquote(value);
+        replace_string(&pconfig->assembly_dir, value);
     else if (MATCH("mono", "config_dir"))
-        pconfig->config_dir = inf_dup_unquote(value);
+        replace_string(&pconfig->config_dir, value);
     else if (MATCH("mono", "default_assembly"))
-        pconfig->default_assembly = inf_dup_unquote(value);
+        replace_string(&pconfig->default_assembly, value);
     else if (MATCH("nx", "svc_io_redirect"))
         pconfig->svc_io_redirect = (strcmp(value, "true") == 0);
     else if (MATCH("nx", "udp_io_redirect"))
-        pconfig->udp_io_redirect = inf_dup_unquote(value);
+        replace_string(&pconfig->udp_io_redirect, value);
     else if (MATCH("nx", "file_io_redirect"))
-        pconfig->file_io_redirect = inf_dup_unquote(value);
+        replace_string(&pconfig->file_io_redirect, value);
     else if (MATCH("nx", "force_console_init"))
         pconfig->force_console_init = (strcmp(value, "true") == 0);
     else if (MATCH("nx", "exit_process_on_end"))
         pconfig->exit_process_on_end = (strcmp(value, "true") == 0);
+    else if (MATCH("nx", "startup_profile"))
+        pconfig->startup_profile = (strcmp(value, "true") == 0);
+    else if (MATCH("nx", "fast_random"))
+        pconfig->fast_random = (strcmp(value, "true") == 0);
+    else if (MATCH("io", "read_cache"))
+        pconfig->read_cache = (strcmp(value, "true") == 0);
+    else if (MATCH("io", "read_cache_paths"))
+        replace_string(&pconfig->read_cache_paths, value);
+    else if (MATCH("io", "read_cache_size_kb"))
+        pconfig->read_cache_size_kb = atoi(value);
+    else if (MATCH("io", "read_cache_block_kb"))
+        pconfig->read_cache_block_kb = atoi(value);
+    else if (MATCH("io", "read_cache_readahead"))
+        pconfig->read_cache_readahead = atoi(value);
+    else if (MATCH("io", "probe_cache"))
+        pconfig->probe_cache = (strcmp(value, "true") == 0);
+    else if (MATCH("interp", "inline"))
+        pconfig->interp_inline = (strcmp(value, "true") == 0);
+    else if (MATCH("interp", "cprop"))
+        pconfig->interp_cprop = (strcmp(value, "true") == 0);
+    else if (MATCH("interp", "super_instructions"))
+        pconfig->interp_super_instructions = (strcmp(value, "true") == 0);
+    else if (MATCH("interp", "bblocks"))
+        pconfig->interp_bblocks = (strcmp(value, "true") == 0);
+    else if (MATCH("interp", "tiering"))
+        pconfig->interp_tiering = (strcmp(value, "true") == 0);
+    else if (MATCH("interp", "simd"))
+        pconfig->interp_simd = (strcmp(value, "true") == 0);
+    else if (MATCH("interp", "options"))
+        replace_string(&pconfig->interp_options, value);
+    else if (MATCH("jit", "enabled"))
+        pconfig->jit_enabled = (strcmp(value, "true") == 0);
+    else if (MATCH("jit", "region_size_mb"))
+        pconfig->jit_region_size_mb = atoi(value);
+    else if (MATCH("jit", "max_regions"))
+        pconfig->jit_max_regions = atoi(value);
+    else if (MATCH("sockets", "tcp_tx_buf_kb"))
+        pconfig->socket_tcp_tx_buf_kb = atoi(value);
+    else if (MATCH("sockets", "tcp_rx_buf_kb"))
+        pconfig->socket_tcp_rx_buf_kb = atoi(value);
+    else if (MATCH("sockets", "tcp_tx_buf_max_kb"))
+        pconfig->socket_tcp_tx_buf_max_kb = atoi(value);
+    else if (MATCH("sockets", "tcp_rx_buf_max_kb"))
+        pconfig->socket_tcp_rx_buf_max_kb = atoi(value);
+    else if (MATCH("sockets", "udp_tx_buf_kb"))
+        pconfig->socket_udp_tx_buf_kb = atoi(value);
+    else if (MATCH("sockets", "udp_rx_buf_kb"))
+        pconfig->socket_udp_rx_buf_kb = atoi(value);
+    else if (MATCH("sockets", "sb_efficiency"))
+        pconfig->socket_sb_efficiency = atoi(value);
+    else if (MATCH("sockets", "sessions"))
+        pconfig->socket_sessions = atoi(value);
+    else if (MATCH("sockets", "dns_cache_ttl"))
+        pconfig->dns_cache_ttl = atoi(value);
+    else if (MATCH("sockets", "dns_negative_ttl"))
+        pconfig->dns_negative_ttl = atoi(value);
+    else if (MATCH("sockets", "dns_cache_entries"))
+        pconfig->dns_cache_entries = atoi(value);
+    else if (strcmp(section, "threads") == 0)
+        return handle_thread_policy_line(pconfig, name, value);
     else
     {
         return 0; /* unknown section/name, error */
@@ -198,10 +358,69 @@ static int handle_ini_line(void *user, const char *section, const char *name, co
 // heap.c
 extern void heap_debug();
 
+static void read_cache_initialize()
+{
+    if (!g_config.read_cache && !g_config.probe_cache)
+        return;
+
+    // A block count of 0 installs the wrapper with only the probe cache
+    struct IoCacheOptions options = { 0 };
+
+    if (g_config.read_cache)
+    {
+        if (g_config.read_cache_block_kb <= 0 || g_config.read_cache_size_kb < g_config.read_cache_block_kb * 2)
+            io_debugf("Invalid read cache size, the cache will be disabled");
+        else
+        {
+            options.block_size = (size_t)g_config.read_cache_block_kb * 1024;
+            options.block_count = (size_t)(g_config.read_cache_size_kb / g_config.read_cache_block_kb);
+            options.readahead_blocks = g_config.read_cache_readahead > 0 ? g_config.read_cache_readahead : 1;
+        }
+    }
+
+    if (!options.block_count && !g_config.probe_cache)
+        return;
+
+    if (!io_cache_install("sdmc", &options))
+    {
+        io_debugf("Failed to install the read cache");
+        return;
+    }
+
+    // Framework assemblies are always cached, app data only if requested in the config
+    io_cache_add_paths(g_config.assembly_dir);
+    io_cache_add_paths(g_config.read_cache_paths);
+
+    // Mono probes every assembly_dir folder for each reference, answer those from a listing taken now
+    if (g_config.probe_cache)
+        io_cache_add_probe_paths(g_config.assembly_dir);
+}
+
 bool application_initialize(const char* configFile)
 {
     memset(&g_config, 0, sizeof(struct AppConfiguration));
 
+    // Defaults for options that are enabled unless the config says otherwise
+    g_config.read_cache = true;
+    g_config.read_cache_size_kb = 4 * 1024;
+    g_config.read_cache_block_kb = 64;
+    g_config.read_cache_readahead = 4;
+    g_config.probe_cache = true;
+    g_config.interp_inline = true;
+    g_config.interp_cprop = true;
+    g_config.interp_super_instructions = true;
+    g_config.interp_bblocks = true;
+    g_config.interp_tiering = true;
+    g_config.interp_simd = true;
+    g_config.jit_region_size_mb = 32;
+    g_config.jit_max_regions = 4;
+    g_config.dns_cache_ttl = 60;
+    g_config.dns_negative_ttl = 10;
+    g_config.dns_cache_entries = 64;
+    g_config.monitor_spin = 100;
+    for (int i = 0; i < ThreadKind_Count; i++)
+        g_config.threads[i].priority = -1;
+
     if (ini_parse(configFile, handle_ini_line, &g_config) < 0)
     {
         io_debugf("Can't load app config from %s", configFile);
@@ -209,6 +428,11 @@ bool application_initialize(const char* configFile)
         return false;
     }
 
+    profiler_init(g_config.startup_profile);
+
+    // This must happen before any other file is opened, see io_cache.h
+    read_cache_initialize();
+
     if (g_config.mono_runtime_logging)
         g_config.mononx_logging = true; // mononx_logging implies mono_runtime_logging
 
@@ -217,6 +441,7 @@ bool application_initialize(const char* configFile)
     
     // It's fine if this fails, the runtime has fallbacks for it.
     csrngInitialize();
+    secure_random_initialize(g_config.fast_random);
 
     if (g_config.file_io_redirect)
     {
@@ -258,11 +483,54 @@ bool application_initialize(const char* configFile)
         return false;
     }
 
+    profiler_mark("icu loaded");
+
     mono_set_dirs(g_config.assembly_dir, g_config.config_dir);   
 
     return true;
 }
 
+// Options used by application_initialize, the paths are passed to mono and icu and the I/O setup is done by then
+static const char *startup_only_options[][2] = {
+    { "mono", "icu" },
+    { "mono", "assembly_dir" },
+    { "mono", "config_dir" },
+    { "mono", "default_assembly" },
+    { "nx", "svc_io_redirect" },
+    { "nx", "udp_io_redirect" },
+    { "nx", "file_io_redirect" },
+    { "nx", "force_console_init" },
+    { "nx", "startup_profile" },
+    { "nx", "fast_random" },
+    { "io", NULL },
+};
+
+static int handle_override_line(void *user, const char *section, const char *name, const char *value)
+{
+    int count = sizeof(startup_only_options) / sizeof(startup_only_options[0]);
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(section, startup_only_options[i][0]) == 0 && (!startup_only_options[i][1] || strcmp(name, startup_only_options[i][1]) == 0))
+        {
+            io_debugf("[%s] %s can only be set in the main config, ignored", section, name);
+            return 1;
+        }
+    }
+
+    return handle_ini_line(user, section, name, value);
+}
+
+bool application_apply_config_text(const char* text)
+{
+    if (ini_parse_string(text, handle_override_line, &g_config) < 0)
+        return false;
+
+    if (g_config.mono_runtime_logging)
+        g_config.mononx_logging = true;
+
+    return true;
+}
+
 void application_configure_mono()
 {
     if (g_config.mono_runtime_logging)
@@ -274,6 +542,115 @@ void application_configure_mono()
 
     mono_dl_fallback_register(dlshim_loadLibrary, dlshim_getSymbol, dlshim_closeLibrary, NULL);
     mono_install_unhandled_exception_hook(Mono_unhandledExceptionHook, NULL);
+
+    // After the bundle config was applied, runtime threads are only created by mono_jit_init
+    thread_policy_install(g_config.threads);
+
+    size_t stack_sizes[ThreadStackKind_Count];
+    for (int i = 0; i < ThreadStackKind_Count; i++)
+        stack_sizes[i] = (size_t)g_config.thread_stack_kb[i] * 1024;
+    thread_stacks_initialize(stack_sizes, g_config.thread_stack_report);
+    low_level_monitor_initialize(g_config.native_monitor, g_config.monitor_spin);
+
+    dns_cache_configure(g_config.dns_cache_ttl, g_config.dns_negative_ttl, g_config.dns_cache_entries);
+}
+
+static char interp_options[256];
+
+static void append_interp_option(size_t *length, const char *option)
+{
+    int written = snprintf(interp_options + *length, sizeof(interp_options) - *length, "%s%s", *length ? "," : "", option);
+    if (written < 0 || *length + written >= sizeof(interp_options))
+    {
+        io_debugf("Interpreter options are too long, ignoring %s", option);
+        interp_options[*length] = '\0';
+        return;
+    }
+
+    *length += written;
+}
+
+void application_configure_interpreter()
+{
+    size_t length = 0;
+
+    // A leading - disables an optimization, see interp_parse_options in mono/mini/interp/interp.c
+    if (!g_config.interp_inline)
+        append_interp_option(&length, "-inline");
+    if (!g_config.interp_cprop)
+        append_interp_option(&length, "-cprop");
+    if (!g_config.interp_super_instructions)
+        append_interp_option(&length, "-super");
+    if (!g_config.interp_bblocks)
+        append_interp_option(&length, "-bblocks");
+    if (!g_config.interp_tiering)
+        append_interp_option(&length, "-tiering");
+    if (!g_config.interp_simd)
+        append_interp_option(&length, "-simd");
+    if (g_config.interp_options && g_config.interp_options[0])
+        append_interp_option(&length, g_config.interp_options);
+
+    if (!length)
+        return;
+
+    // mono keeps a pointer to the option string so it can't be on the stack
+    static char argument[sizeof(interp_options) + 16];
+    snprintf(argument, sizeof(argument), "--interp=%s", interp_options);
+
+    io_debugf("Interpreter options: %s", interp_options);
+
+    // --interp also selects the interpreter execution mode, the launcher sets the actual aot mode right after this
+    char *argv[] = { argument };
+    mono_jit_parse_options(1, argv);
+}
+
+const char *application_interp_options()
+{
+    return interp_options;
+}
+
+static const char *execution_mode = "interpreter";
+
+void application_set_execution_mode(const char *mode)
+{
+    execution_mode = mode;
+}
+
+const char *application_execution_mode()
+{
+    return execution_mode;
+}
+
+// Defined by mono builds whose code manager allocates from jit_memory.c, without it mono would try to map RWX memory
+extern const int mono_nx_codeman_host_memory __attribute__((weak));
+
+bool application_configure_jit()
+{
+    if (&mono_nx_codeman_host_memory == NULL)
+    {
+        io_debugf("This mono build doesn't support JIT, using the interpreter");
+        return false;
+    }
+
+    if (g_config.jit_region_size_mb <= 0 || !jit_memory_initialize((size_t)g_config.jit_region_size_mb * 1024 * 1024, g_config.jit_max_regions))
+    {
+        io_debugf("JIT memory is not available, using the interpreter");
+        return false;
+    }
+
+    // Null references can't be caught as memory faults on switch, generated code must check for them explicitly
+    const char *debug = getenv("MONO_DEBUG");
+    if (debug && debug[0])
+    {
+        char combined[256];
+        snprintf(combined, sizeof(combined), "%s,explicit-null-checks", debug);
+        setenv("MONO_DEBUG", combined, 1);
+    }
+    else
+        setenv("MONO_DEBUG", "explicit-null-checks", 1);
+
+    execution_mode = "jit";
+    return true;
 }
 
 // Internal libnx symbol
@@ -283,12 +660,16 @@ void application_terminate()
 {
     io_debugf("Terminating application");
 
+    thread_stacks_report();
+
     // These symbols are defined in mono and needed to clean up our hacks needed to get it to work on switch.
     extern void mono_nx_jit_force_dispose(void);
     mono_nx_jit_force_dispose();
 
     extern void mono_nx_fakemmap_release(void);
     mono_nx_fakemmap_release();
+
+    jit_memory_dispose();
     
     csrngExit();
     
@@ -306,6 +687,8 @@ void application_terminate()
     if (g_config.default_assembly) free(g_config.default_assembly);
     if (g_config.udp_io_redirect) free(g_config.udp_io_redirect);
     if (g_config.file_io_redirect) free(g_config.file_io_redirect);
+    if (g_config.read_cache_paths) free(g_config.read_cache_paths);
+    if (g_config.interp_options) free(g_config.interp_options);
 
     if (g_config.exit_process_on_end) 
     {
@@ -8,7 +8,13 @@
 #include <switch.h>
 
 #include "io_util.h"
+#include "io_cache.h"
+#include "profiler.h"
+#include "bundle.h"
 #include "dl_shim.h"
+#include "jit_memory.h"
+#include "thread_policy.h"
+#include "thread_stacks.h"
 #include "third_party/ini/ini.h"
 
 #include <mono/jit/jit.h>
@@ -41,6 +47,52 @@ struct AppConfiguration
 
     bool force_console_init;
     bool exit_process_on_end;
+    bool startup_profile;
+    bool fast_random;
+
+    bool read_cache;
+    char *read_cache_paths;
+    int read_cache_size_kb;
+    int read_cache_block_kb;
+    int read_cache_readahead;
+
+    bool probe_cache;
+
+    // Interpreter optimizations, all of them are enabled by default in mono
+    bool interp_inline;
+    bool interp_cprop;
+    bool interp_super_instructions;
+    bool interp_bblocks;
+    bool interp_tiering;
+    bool interp_simd;
+    char *interp_options;
+
+    bool jit_enabled;
+    int jit_region_size_mb;
+    int jit_max_regions;
+
+    // [sockets] bsd service configuration, 0 keeps the libnx default
+    int socket_tcp_tx_buf_kb;
+    int socket_tcp_rx_buf_kb;
+    int socket_tcp_tx_buf_max_kb;
+    int socket_tcp_rx_buf_max_kb;
+    int socket_udp_tx_buf_kb;
+    int socket_udp_rx_buf_kb;
+    int socket_sb_efficiency;
+    int socket_sessions;
+    // [sockets] host name cache in front of SystemNative_GetHostEntryForName, ttl 0 disables it
+    int dns_cache_ttl;
+    int dns_negative_ttl;
+    int dns_cache_entries;
+
+    // [threads] core masks and priorities, indexed by enum ThreadKind
+    struct ThreadPolicy threads[ThreadKind_Count];
+    // [threads] stack sizes in KB, indexed by enum ThreadStackKind
+    int thread_stack_kb[ThreadStackKind_Count];
+    bool thread_stack_report;
+    // [threads] LowLevelMonitor implementation, see low_level_monitor.h
+    bool native_monitor;
+    int monitor_spin;
 };
 
 extern struct AppConfiguration g_config;
@@ -48,9 +100,25 @@ extern struct AppConfiguration g_config;
 // Loads config
 bool application_initialize(const char* configFile);
 
+// Applies ini text on top of the loaded config, used for per-app overrides. Options already used by application_initialize are ignored
+bool application_apply_config_text(const char* text);
+
 // Sets up dlshim and exception hooks
 void application_configure_mono();
 
+// Passes the [interp] options to mono, must be called before mono_jit_set_aot_mode and mono_jit_init
+void application_configure_interpreter();
+
+// Interpreter options applied by application_configure_interpreter, empty if mono's defaults are used
+const char *application_interp_options();
+
+// Reserves the JIT code memory, returns false if this mono build or the system can't JIT and the interpreter must be used instead
+bool application_configure_jit();
+
+// Name of the execution mode picked by the launcher, reported to managed code for benchmarks
+void application_set_execution_mode(const char *mode);
+const char *application_execution_mode();
+
 void application_terminate();
 
 void application_chdir_to_assembly(const char* path);
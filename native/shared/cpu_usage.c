@@ -0,0 +1,62 @@
+#include "cpu_usage.h"
+#include "io_util.h"
+
+#include <switch.h>
+
+// Cores the process is allowed to run on, 0 until the first sample
+static u64 process_core_mask;
+
+bool cpu_usage_sample(uint64_t *tick, uint64_t *idle_ticks, int *core_count)
+{
+    if (!process_core_mask)
+    {
+        Result rc = svcGetInfo(&process_core_mask, InfoType_CoreMask, CUR_PROCESS_HANDLE, 0);
+        if (R_FAILED(rc))
+        {
+            io_debugf("cpu_usage: InfoType_CoreMask failed: %x", rc);
+            return false;
+        }
+    }
+
+    // The idle tick count can only be read for the core the caller is running on, so the thread moves to each core in turn.
+    // This is called by the thread pool gate thread about twice per second, three migrations are cheaper than keeping a sampling thread on each core.
+    s32 ideal_core;
+    u64 affinity_mask;
+    Result rc = svcGetThreadCoreMask(&ideal_core, &affinity_mask, CUR_THREAD_HANDLE);
+    if (R_FAILED(rc))
+        return false;
+
+    u64 total = 0;
+    int count = 0;
+
+    for (int core = 0; core < 32; core++)
+    {
+        if (!(process_core_mask & (1ull << core)))
+            continue;
+
+        u64 idle = 0;
+        rc = svcSetThreadCoreMask(CUR_THREAD_HANDLE, core, 1u << core);
+        if (R_SUCCEEDED(rc))
+            rc = svcGetInfo(&idle, InfoType_IdleTickCount, INVALID_HANDLE, (u64)-1);
+
+        if (R_FAILED(rc))
+        {
+            io_debugf("cpu_usage: sampling core %d failed: %x", core, rc);
+            break;
+        }
+
+        total += idle;
+        count++;
+    }
+
+    // Put the thread back where the runtime wanted it, whatever happened above
+    svcSetThreadCoreMask(CUR_THREAD_HANDLE, ideal_core, affinity_mask);
+
+    if (R_FAILED(rc) || count == 0)
+        return false;
+
+    *tick = armGetSystemTick();
+    *idle_ticks = total;
+    *core_count = count;
+    return true;
+}
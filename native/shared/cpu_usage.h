@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// CPU utilization for the thread pool, see SystemNative_GetCpuUtilization_Hook in dl_shim_dotnet.c
+// The kernel keeps the ticks spent by the idle thread of each core, the busy time of a core is the elapsed time minus its idle time.
+// This is system wide like GetSystemTimes on windows, other processes running on the application cores count as busy.
+
+// Samples the idle ticks of every core the process can run on.
+// tick is the system tick of the sample, idle_ticks the sum of the idle ticks of all cores and core_count how many cores were sampled.
+bool cpu_usage_sample(uint64_t *tick, uint64_t *idle_ticks, int *core_count);
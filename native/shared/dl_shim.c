@@ -1,5 +1,6 @@
 #include "core.h"
 #include "dl_shim.h"
+#include "dns_cache.h"
 
 #define REGISTER_LIBRARY(name, string, id) \
 	const intptr_t LibHandle_##name = (intptr_t)(0xABC00000 | id); \
@@ -148,6 +149,10 @@ void* getsym_Internal(const char *name)
 	if (strcmp(name, "console_ensure_init") == 0) return (void *)console_ensure_init;
     else if (strcmp(name, "console_dispose") == 0) return (void *)console_dispose;
     else if (strcmp(name, "console_update") == 0) return(void *)console_update;
+    else if (strcmp(name, "application_interp_options") == 0) return(void *)application_interp_options;
+    else if (strcmp(name, "application_execution_mode") == 0) return(void *)application_execution_mode;
+    else if (strcmp(name, "dns_cache_get_stats") == 0) return(void *)dns_cache_get_stats;
+    else if (strcmp(name, "dns_cache_clear") == 0) return(void *)dns_cache_clear;
 
 	return NULL;
 }
\ No newline at end of file
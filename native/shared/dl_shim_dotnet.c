@@ -1,4 +1,17 @@
 #include "dl_shim_base.h"
+#include "cpu_usage.h"
+#include "thread_policy.h"
+#include "thread_stacks.h"
+#include "socket_event_port.h"
+#include "socket_sendfile.h"
+#include "dns_cache.h"
+#include "secure_random.h"
+#include "low_level_monitor.h"
+#include <switch.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 // I noticed that bsd would sometimes crash when running the nro multiple times.
 // This should have been fixed now but regardless, we only initialize sockets once if actually needed.
@@ -11,9 +24,338 @@ int32_t SystemNative_Socket_Hook(int32_t addressFamily, int32_t socketType, int3
     return SystemNative_Socket(addressFamily, socketType, protocolType, createdSocket);
 }
 
+// The PAL is built without HAVE_PREADV so it would issue one pread per vector, route these to our vectored implementation in io_shims.c instead.
+// IOVector has the same layout as struct iovec.
+int64_t SystemNative_PReadV_Hook(intptr_t fd, struct iovec* vectors, int32_t vectorCount, int64_t fileOffset)
+{
+    extern ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t off);
+
+    ssize_t res;
+    while ((res = preadv((int)fd, vectors, vectorCount, (off_t)fileOffset)) < 0 && errno == EINTR);
+    return res;
+}
+
+int64_t SystemNative_PWriteV_Hook(intptr_t fd, struct iovec* vectors, int32_t vectorCount, int64_t fileOffset)
+{
+    extern ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t off);
+
+    ssize_t res;
+    while ((res = pwritev((int)fd, vectors, vectorCount, (off_t)fileOffset)) < 0 && errno == EINTR);
+    return res;
+}
+
+// Must match ProcessCpuInformation in the PAL, the struct is owned by the managed caller and only passed back to us
+typedef struct
+{
+    uint64_t lastRecordedCurrentTime;
+    uint64_t lastRecordedKernelTime;
+    uint64_t lastRecordedUserTime;
+} ProcessCpuInformation;
+
+// The PAL implementation is a stub that always returns 0, so PortableThreadPool thinks the CPU is always idle and its starvation
+// and hill climbing heuristics keep adding threads. Compute the real utilization of the application cores from their idle ticks.
+// The previous sample is stored in the caller's struct: lastRecordedCurrentTime is the system tick and lastRecordedKernelTime the idle ticks.
+int32_t SystemNative_GetCpuUtilization_Hook(ProcessCpuInformation* previousCpuInfo)
+{
+    uint64_t tick, idle;
+    int cores;
+    if (!cpu_usage_sample(&tick, &idle, &cores))
+        return 0;
+
+    int32_t utilization = 0;
+
+    // The first call only records the sample, same as the PAL
+    if (previousCpuInfo->lastRecordedCurrentTime && tick > previousCpuInfo->lastRecordedCurrentTime && idle >= previousCpuInfo->lastRecordedKernelTime)
+    {
+        uint64_t capacity = (tick - previousCpuInfo->lastRecordedCurrentTime) * cores;
+        uint64_t idle_delta = idle - previousCpuInfo->lastRecordedKernelTime;
+        uint64_t busy = idle_delta < capacity ? capacity - idle_delta : 0;
+        utilization = (int32_t)(busy * 100 / capacity);
+    }
+
+    previousCpuInfo->lastRecordedCurrentTime = tick;
+    previousCpuInfo->lastRecordedKernelTime = idle;
+    previousCpuInfo->lastRecordedUserTime = 0;
+
+    return utilization;
+}
+
+// There is a single process on switch, so affinity and priority apply to the calling thread whatever pid is passed.
+// Bit n of the mask is core n, see thread_policy.h
+int32_t SystemNative_SchedSetAffinity_Hook(int32_t pid, intptr_t* mask)
+{
+    if (!thread_policy_set_current((uint32_t)*mask, -1))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t SystemNative_SchedGetAffinity_Hook(int32_t pid, intptr_t* mask)
+{
+    uint32_t core_mask;
+    int priority;
+    if (!thread_policy_get_current(&core_mask, &priority))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    *mask = (intptr_t)core_mask;
+    return 0;
+}
+
+int32_t SystemNative_SchedGetCpu_Hook()
+{
+    return (int32_t)svcGetCurrentProcessorNumber();
+}
+
+// Nice values go from -20 to 19 with 0 the default, switch priorities from 0 to 0x3F with 0x2C the default of the main thread
+#define NICE_DEFAULT_PRIORITY 0x2C
+
+int32_t SystemNative_GetPriority_Hook(int32_t which, int32_t who, int32_t* priorityValue)
+{
+    uint32_t core_mask;
+    int priority;
+    if (!thread_policy_get_current(&core_mask, &priority))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    *priorityValue = priority - NICE_DEFAULT_PRIORITY;
+    return 0;
+}
+
+int32_t SystemNative_SetPriority_Hook(int32_t which, int32_t who, int32_t nice)
+{
+    // Clamp to the priorities the process is allowed to use
+    u64 allowed = 0;
+    int highest = 0x20;
+    if (R_SUCCEEDED(svcGetInfo(&allowed, InfoType_PriorityMask, CUR_PROCESS_HANDLE, 0)) && allowed)
+        highest = __builtin_ctzll(allowed);
+
+    int priority = NICE_DEFAULT_PRIORITY + nice;
+    priority = priority < highest ? highest : priority > 0x3F ? 0x3F : priority;
+
+    if (!thread_policy_set_current(0, priority))
+    {
+        errno = EPERM;
+        return -1;
+    }
+    return 0;
+}
+
+// SystemNative_CreateThread is used by the runtime for its native helper threads, mark them so the
+// pthread_create wrapper in thread_stacks.c doesn't mistake them for managed threads.
+int32_t SystemNative_CreateThread_Hook(uintptr_t stackSize, void *(*startAddress)(void*), void *parameter)
+{
+    extern int32_t SystemNative_CreateThread(uintptr_t stackSize, void *(*startAddress)(void*), void *parameter);
+
+    thread_stacks_next_is_native(true);
+    int32_t res = SystemNative_CreateThread(stackSize, startAddress, parameter);
+    thread_stacks_next_is_native(false);
+    return res;
+}
+
+// Declared at file scope since it is also resolved for managed code below
+int32_t SystemNative_ConvertErrorPlatformToPal(int32_t platformErrno);
+
+// SocketEventPort on top of poll, see socket_event_port.h. Ports are pointers, the managed side only passes them back to us.
+int32_t SystemNative_CreateSocketEventPort_Hook(intptr_t* port)
+{
+    extern void socket_esnure_init_thread_safe();
+
+    socket_esnure_init_thread_safe();
+
+    struct socket_event_port *result;
+    int error = socket_event_port_create(&result);
+    if (error)
+        return SystemNative_ConvertErrorPlatformToPal(error);
+
+    *port = (intptr_t)result;
+    return 0;
+}
+
+int32_t SystemNative_CloseSocketEventPort_Hook(intptr_t port)
+{
+    socket_event_port_close((struct socket_event_port *)port);
+    return 0;
+}
+
+// Without epoll the PAL sizes the buffer elements as 0 bytes, ours are the SocketEvents themselves
+int32_t SystemNative_CreateSocketEventBuffer_Hook(int32_t count, struct socket_event** buffer)
+{
+    *buffer = malloc(sizeof(struct socket_event) * count);
+    return *buffer ? 0 : SystemNative_ConvertErrorPlatformToPal(ENOMEM);
+}
+
+int32_t SystemNative_FreeSocketEventBuffer_Hook(struct socket_event* buffer)
+{
+    free(buffer);
+    return 0;
+}
+
+int32_t SystemNative_TryChangeSocketEventRegistration_Hook(intptr_t port, intptr_t socket, int32_t currentEvents, int32_t newEvents, uintptr_t data)
+{
+    int error = socket_event_port_change((struct socket_event_port *)port, (int)socket, newEvents, data);
+    return error ? SystemNative_ConvertErrorPlatformToPal(error) : 0;
+}
+
+int32_t SystemNative_WaitForSocketEvents_Hook(intptr_t port, struct socket_event* buffer, int32_t* count)
+{
+    int error = socket_event_port_wait((struct socket_event_port *)port, buffer, count);
+    return error ? SystemNative_ConvertErrorPlatformToPal(error) : 0;
+}
+
+// Reported events stay masked until the socket would block again, which is when the managed side starts waiting for one
+static void rearm_if_blocked(intptr_t socket, int32_t error, int32_t events)
+{
+    if (error && (error == SystemNative_ConvertErrorPlatformToPal(EAGAIN) || error == SystemNative_ConvertErrorPlatformToPal(EINPROGRESS)))
+        socket_event_port_rearm((int)socket, events);
+}
+
+int32_t SystemNative_Receive_Hook(intptr_t socket, void* buffer, int32_t bufferLen, int32_t flags, int32_t* received)
+{
+    extern int32_t SystemNative_Receive(intptr_t socket, void* buffer, int32_t bufferLen, int32_t flags, int32_t* received);
+
+    int32_t res = SystemNative_Receive(socket, buffer, bufferLen, flags, received);
+    rearm_if_blocked(socket, res, SOCKET_EVENT_READ);
+    return res;
+}
+
+int32_t SystemNative_ReceiveMessage_Hook(intptr_t socket, void* messageHeader, int32_t flags, int64_t* received)
+{
+    extern int32_t SystemNative_ReceiveMessage(intptr_t socket, void* messageHeader, int32_t flags, int64_t* received);
+
+    int32_t res = SystemNative_ReceiveMessage(socket, messageHeader, flags, received);
+    rearm_if_blocked(socket, res, SOCKET_EVENT_READ);
+    return res;
+}
+
+int32_t SystemNative_Accept_Hook(intptr_t socket, uint8_t* socketAddress, int32_t* socketAddressLen, intptr_t* acceptedSocket)
+{
+    extern int32_t SystemNative_Accept(intptr_t socket, uint8_t* socketAddress, int32_t* socketAddressLen, intptr_t* acceptedSocket);
+
+    int32_t res = SystemNative_Accept(socket, socketAddress, socketAddressLen, acceptedSocket);
+    rearm_if_blocked(socket, res, SOCKET_EVENT_READ);
+    return res;
+}
+
+int32_t SystemNative_Send_Hook(intptr_t socket, void* buffer, int32_t bufferLen, int32_t flags, int32_t* sent)
+{
+    extern int32_t SystemNative_Send(intptr_t socket, void* buffer, int32_t bufferLen, int32_t flags, int32_t* sent);
+
+    int32_t res = SystemNative_Send(socket, buffer, bufferLen, flags, sent);
+    rearm_if_blocked(socket, res, SOCKET_EVENT_WRITE);
+    return res;
+}
+
+int32_t SystemNative_SendMessage_Hook(intptr_t socket, void* messageHeader, int32_t flags, int64_t* sent)
+{
+    extern int32_t SystemNative_SendMessage(intptr_t socket, void* messageHeader, int32_t flags, int64_t* sent);
+
+    int32_t res = SystemNative_SendMessage(socket, messageHeader, flags, sent);
+    rearm_if_blocked(socket, res, SOCKET_EVENT_WRITE);
+    return res;
+}
+
+// The PAL has no sendfile to use on switch and returns ENOTSUP, see socket_sendfile.h
+int32_t SystemNative_SendFile_Hook(intptr_t out_fd, intptr_t in_fd, int64_t offset, int64_t count, int64_t* sent)
+{
+    int error = socket_sendfile((int)out_fd, (int)in_fd, offset, count, sent);
+    int32_t res = error ? SystemNative_ConvertErrorPlatformToPal(error) : 0;
+    rearm_if_blocked(out_fd, res, SOCKET_EVENT_WRITE);
+    return res;
+}
+
+int32_t SystemNative_Connect_Hook(intptr_t socket, uint8_t* socketAddress, int32_t socketAddressLen)
+{
+    extern int32_t SystemNative_Connect(intptr_t socket, uint8_t* socketAddress, int32_t socketAddressLen);
+
+    int32_t res = SystemNative_Connect(socket, socketAddress, socketAddressLen);
+    rearm_if_blocked(socket, res, SOCKET_EVENT_WRITE);
+    return res;
+}
+
+// Sockets are closed without being unregistered, epoll forgets them on its own
+int32_t SystemNative_Close_Hook(intptr_t fd)
+{
+    extern int32_t SystemNative_Close(intptr_t fd);
+
+    socket_event_port_forget((int)fd);
+    return SystemNative_Close(fd);
+}
+
+// Every new connection to a host name resolves it again, see dns_cache.h
+int32_t SystemNative_GetHostEntryForName_Hook(const uint8_t* address, int32_t addressFamily, HostEntry* entry)
+{
+    extern int32_t SystemNative_GetHostEntryForName(const uint8_t* address, int32_t addressFamily, HostEntry* entry);
+
+    return dns_cache_resolve(address, addressFamily, entry, SystemNative_GetHostEntryForName);
+}
+
+// Both fall back to the PAL when the generator is disabled or has no seed, see secure_random.h
+int32_t SystemNative_GetCryptographicallySecureRandomBytes_Hook(uint8_t* buffer, int32_t bufferLength)
+{
+    extern int32_t SystemNative_GetCryptographicallySecureRandomBytes(uint8_t* buffer, int32_t bufferLength);
+
+    if (bufferLength >= 0 && secure_random_bytes(buffer, (size_t)bufferLength) == 0)
+        return 0;
+
+    return SystemNative_GetCryptographicallySecureRandomBytes(buffer, bufferLength);
+}
+
+void SystemNative_GetNonCryptographicallySecureRandomBytes_Hook(uint8_t* buffer, int32_t bufferLength)
+{
+    extern void SystemNative_GetNonCryptographicallySecureRandomBytes(uint8_t* buffer, int32_t bufferLength);
+
+    if (bufferLength >= 0 && secure_random_bytes(buffer, (size_t)bufferLength) == 0)
+        return;
+
+    SystemNative_GetNonCryptographicallySecureRandomBytes(buffer, bufferLength);
+}
+
 void *getsym_SystemNative(const char *name)
 {
+    // The PAL functions below are used when disabled in the config
+    if (low_level_monitor_enabled())
+    {
+        SYM_RESOLVE_EXISTING_NAMED("SystemNative_LowLevelMonitor_Create", low_level_monitor_create);
+        SYM_RESOLVE_EXISTING_NAMED("SystemNative_LowLevelMonitor_Destroy", low_level_monitor_destroy);
+        SYM_RESOLVE_EXISTING_NAMED("SystemNative_LowLevelMonitor_Acquire", low_level_monitor_acquire);
+        SYM_RESOLVE_EXISTING_NAMED("SystemNative_LowLevelMonitor_Release", low_level_monitor_release);
+        SYM_RESOLVE_EXISTING_NAMED("SystemNative_LowLevelMonitor_Wait", low_level_monitor_wait);
+        SYM_RESOLVE_EXISTING_NAMED("SystemNative_LowLevelMonitor_TimedWait", low_level_monitor_timed_wait);
+        SYM_RESOLVE_EXISTING_NAMED("SystemNative_LowLevelMonitor_Signal_Release", low_level_monitor_signal_release);
+    }
+
     SYM_RESOLVE_EXISTING_NAMED("SystemNative_Socket", SystemNative_Socket_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_PReadV", SystemNative_PReadV_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_PWriteV", SystemNative_PWriteV_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_GetCpuUtilization", SystemNative_GetCpuUtilization_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_SchedSetAffinity", SystemNative_SchedSetAffinity_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_SchedGetAffinity", SystemNative_SchedGetAffinity_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_SchedGetCpu", SystemNative_SchedGetCpu_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_GetPriority", SystemNative_GetPriority_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_SetPriority", SystemNative_SetPriority_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_CreateThread", SystemNative_CreateThread_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_CreateSocketEventPort", SystemNative_CreateSocketEventPort_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_CloseSocketEventPort", SystemNative_CloseSocketEventPort_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_CreateSocketEventBuffer", SystemNative_CreateSocketEventBuffer_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_FreeSocketEventBuffer", SystemNative_FreeSocketEventBuffer_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_TryChangeSocketEventRegistration", SystemNative_TryChangeSocketEventRegistration_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_WaitForSocketEvents", SystemNative_WaitForSocketEvents_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_Receive", SystemNative_Receive_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_ReceiveMessage", SystemNative_ReceiveMessage_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_Accept", SystemNative_Accept_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_Send", SystemNative_Send_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_SendMessage", SystemNative_SendMessage_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_SendFile", SystemNative_SendFile_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_Connect", SystemNative_Connect_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_Close", SystemNative_Close_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_GetHostEntryForName", SystemNative_GetHostEntryForName_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_GetCryptographicallySecureRandomBytes", SystemNative_GetCryptographicallySecureRandomBytes_Hook);
+    SYM_RESOLVE_EXISTING_NAMED("SystemNative_GetNonCryptographicallySecureRandomBytes", SystemNative_GetNonCryptographicallySecureRandomBytes_Hook);
 
     SYM_RESOLVE(SystemNative_CreateAutoreleasePool);
     SYM_RESOLVE(SystemNative_DrainAutoreleasePool);
@@ -40,7 +382,7 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_GetEnv);
     SYM_RESOLVE(SystemNative_GetEnviron);
     SYM_RESOLVE(SystemNative_FreeEnviron);
-    SYM_RESOLVE(SystemNative_ConvertErrorPlatformToPal);
+    SYM_RESOLVE_EXISTING(SystemNative_ConvertErrorPlatformToPal);
     SYM_RESOLVE(SystemNative_ConvertErrorPalToPlatform);
     SYM_RESOLVE(SystemNative_StrErrorR);
     SYM_RESOLVE(SystemNative_GetErrNo);
@@ -52,7 +394,6 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_Stat);
     SYM_RESOLVE(SystemNative_LStat);
     SYM_RESOLVE(SystemNative_Open);
-    SYM_RESOLVE(SystemNative_Close);
     SYM_RESOLVE(SystemNative_Dup);
     SYM_RESOLVE(SystemNative_Unlink);
     SYM_RESOLVE(SystemNative_ShmOpen);
@@ -115,8 +456,6 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_ReadProcessStatusInfo);
     SYM_RESOLVE(SystemNative_PRead);
     SYM_RESOLVE(SystemNative_PWrite);
-    SYM_RESOLVE(SystemNative_PReadV);
-    SYM_RESOLVE(SystemNative_PWriteV);
     SYM_RESOLVE(SystemNative_iOSSupportVersion);
     SYM_RESOLVE(SystemNative_Log);
     SYM_RESOLVE(SystemNative_LogError);
@@ -130,7 +469,6 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_GetSpaceInfoForMountPoint);
     SYM_RESOLVE(SystemNative_GetFormatInfoForMountPoint);
     SYM_RESOLVE(SystemNative_GetAllMountPoints);
-    SYM_RESOLVE(SystemNative_GetHostEntryForName);
     SYM_RESOLVE(SystemNative_FreeHostEntry);
     SYM_RESOLVE(SystemNative_GetNameInfo);
     SYM_RESOLVE(SystemNative_GetDomainName);
@@ -154,13 +492,7 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_SetLingerOption);
     SYM_RESOLVE(SystemNative_SetReceiveTimeout);
     SYM_RESOLVE(SystemNative_SetSendTimeout);
-    SYM_RESOLVE(SystemNative_Receive);
-    SYM_RESOLVE(SystemNative_ReceiveMessage);
-    SYM_RESOLVE(SystemNative_Send);
-    SYM_RESOLVE(SystemNative_SendMessage);
-    SYM_RESOLVE(SystemNative_Accept);
     SYM_RESOLVE(SystemNative_Bind);
-    SYM_RESOLVE(SystemNative_Connect);
     SYM_RESOLVE(SystemNative_GetPeerName);
     SYM_RESOLVE(SystemNative_GetSockName);
     SYM_RESOLVE(SystemNative_Listen);
@@ -173,16 +505,9 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_GetSocketType);
     SYM_RESOLVE(SystemNative_GetAtOutOfBandMark);
     SYM_RESOLVE(SystemNative_GetBytesAvailable);
-    SYM_RESOLVE(SystemNative_CreateSocketEventPort);
-    SYM_RESOLVE(SystemNative_CloseSocketEventPort);
-    SYM_RESOLVE(SystemNative_CreateSocketEventBuffer);
-    SYM_RESOLVE(SystemNative_FreeSocketEventBuffer);
-    SYM_RESOLVE(SystemNative_TryChangeSocketEventRegistration);
-    SYM_RESOLVE(SystemNative_WaitForSocketEvents);
     SYM_RESOLVE(SystemNative_PlatformSupportsDualModeIPv4PacketInfo);
     SYM_RESOLVE(SystemNative_GetDomainSocketSizes);
     SYM_RESOLVE(SystemNative_GetMaximumAddressSize);
-    SYM_RESOLVE(SystemNative_SendFile);
     SYM_RESOLVE(SystemNative_Disconnect);
     SYM_RESOLVE(SystemNative_InterfaceNameToIndex);
     SYM_RESOLVE(SystemNative_GetTcpGlobalStatistics);
@@ -206,14 +531,8 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_WaitIdAnyExitedNoHangNoWait);
     SYM_RESOLVE(SystemNative_WaitPidExitedNoHang);
     SYM_RESOLVE(SystemNative_PathConf);
-    SYM_RESOLVE(SystemNative_GetPriority);
-    SYM_RESOLVE(SystemNative_SetPriority);
     SYM_RESOLVE(SystemNative_GetCwd);
-    SYM_RESOLVE(SystemNative_SchedSetAffinity);
-    SYM_RESOLVE(SystemNative_SchedGetAffinity);
     SYM_RESOLVE(SystemNative_GetProcessPath);
-    SYM_RESOLVE(SystemNative_GetNonCryptographicallySecureRandomBytes);
-    SYM_RESOLVE(SystemNative_GetCryptographicallySecureRandomBytes);
     SYM_RESOLVE(SystemNative_GetUnixRelease);
     SYM_RESOLVE(SystemNative_GetUnixVersion);
     SYM_RESOLVE(SystemNative_GetOSArchitecture);
@@ -239,8 +558,6 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_LowLevelMonitor_Wait);
     SYM_RESOLVE(SystemNative_LowLevelMonitor_TimedWait);
     SYM_RESOLVE(SystemNative_LowLevelMonitor_Signal_Release);
-    SYM_RESOLVE(SystemNative_CreateThread);
-    SYM_RESOLVE(SystemNative_SchedGetCpu);
     SYM_RESOLVE(SystemNative_Exit);
     SYM_RESOLVE(SystemNative_Abort);
     SYM_RESOLVE(SystemNative_GetUInt64OSThreadId);
@@ -249,7 +566,6 @@ void *getsym_SystemNative(const char *name)
     SYM_RESOLVE(SystemNative_FUTimens);
     SYM_RESOLVE(SystemNative_GetTimestamp);
     SYM_RESOLVE(SystemNative_GetBootTimeTicks);
-    SYM_RESOLVE(SystemNative_GetCpuUtilization);
     SYM_RESOLVE(SystemNative_GetPwUidR);
     SYM_RESOLVE(SystemNative_GetPwNamR);
     SYM_RESOLVE(SystemNative_GetEUid);
@@ -1,4 +1,5 @@
 #include "dl_shim_base.h"
+#include "io_dirread.h"
 #include <switch.h>
 
 u32 extensionPadStateSize() 
@@ -15,6 +16,11 @@ void *getsym_Libnx(const char *name)
     
     SYM_RESOLVE_EXISTING(appletMainLoop);
 
+    // Bulk directory listing, see io_dirread.h
+    SYM_RESOLVE_EXISTING(extensionDirOpen);
+    SYM_RESOLVE_EXISTING(extensionDirRead);
+    SYM_RESOLVE_EXISTING(extensionDirClose);
+
     // Used by opentk
     SYM_RESOLVE_EXISTING(nwindowGetDefault);
     return NULL;
@@ -0,0 +1,228 @@
+#include "dns_cache.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <time.h>
+
+struct cache_entry
+{
+    char *name;
+    int32_t family;
+    int32_t result;
+    uint64_t expires_ms;
+    uint64_t last_used_ms;
+    HostEntry host;
+};
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct cache_entry *entries;
+static int capacity;
+static int count;
+
+static uint64_t ttl_ms;
+static uint64_t negative_ttl_ms;
+
+static struct DnsCacheStats stats;
+
+static uint64_t now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void free_host(HostEntry *host)
+{
+    free(host->CanonicalName);
+    for (int i = 0; i < host->AliasCount; i++)
+        free(host->Aliases[i]);
+    free(host->Aliases);
+    free(host->IPAddressList);
+    memset(host, 0, sizeof(HostEntry));
+}
+
+// Allocates every field separately, the same way the PAL does, so SystemNative_FreeHostEntry can release copies we hand out
+static bool copy_host(HostEntry *dst, const HostEntry *src)
+{
+    memset(dst, 0, sizeof(HostEntry));
+
+    if (src->CanonicalName && !(dst->CanonicalName = (uint8_t *)strdup((const char *)src->CanonicalName)))
+        goto fail;
+
+    if (src->AliasCount > 0 && src->Aliases)
+    {
+        if (!(dst->Aliases = calloc(src->AliasCount + 1, sizeof(uint8_t *))))
+            goto fail;
+
+        for (; dst->AliasCount < src->AliasCount; dst->AliasCount++)
+            if (!(dst->Aliases[dst->AliasCount] = (uint8_t *)strdup((const char *)src->Aliases[dst->AliasCount])))
+                goto fail;
+    }
+
+    if (src->IPAddressCount > 0 && src->IPAddressList)
+    {
+        if (!(dst->IPAddressList = malloc(sizeof(IPAddress) * src->IPAddressCount)))
+            goto fail;
+
+        memcpy(dst->IPAddressList, src->IPAddressList, sizeof(IPAddress) * src->IPAddressCount);
+        dst->IPAddressCount = src->IPAddressCount;
+    }
+
+    return true;
+
+fail:
+    free_host(dst);
+    return false;
+}
+
+static void remove_locked(int index)
+{
+    free(entries[index].name);
+    free_host(&entries[index].host);
+    entries[index] = entries[--count];
+}
+
+static int find_locked(const char *name, int32_t family)
+{
+    for (int i = 0; i < count; i++)
+        if (entries[i].family == family && strcasecmp(entries[i].name, name) == 0)
+            return i;
+    return -1;
+}
+
+// Makes room for one more entry, expired ones go first and then the least recently used
+static void evict_locked(uint64_t now)
+{
+    for (int i = count - 1; i >= 0; i--)
+        if (entries[i].expires_ms <= now)
+            remove_locked(i);
+
+    if (count < capacity)
+        return;
+
+    int oldest = 0;
+    for (int i = 1; i < count; i++)
+        if (entries[i].last_used_ms < entries[oldest].last_used_ms)
+            oldest = i;
+
+    remove_locked(oldest);
+    stats.evictions++;
+}
+
+void dns_cache_configure(int ttl_seconds, int negative_ttl_seconds, int max_entries)
+{
+    pthread_mutex_lock(&mutex);
+
+    while (count)
+        remove_locked(count - 1);
+    free(entries);
+
+    ttl_ms = ttl_seconds > 0 ? (uint64_t)ttl_seconds * 1000 : 0;
+    negative_ttl_ms = negative_ttl_seconds > 0 ? (uint64_t)negative_ttl_seconds * 1000 : 0;
+    capacity = max_entries > 0 ? max_entries : 0;
+    entries = capacity ? calloc(capacity, sizeof(struct cache_entry)) : NULL;
+    if (!entries)
+        capacity = 0;
+
+    pthread_mutex_unlock(&mutex);
+}
+
+int32_t dns_cache_resolve(const uint8_t *name, int32_t family, HostEntry *entry, dns_resolve_fn resolve)
+{
+    // An empty name resolves the local host, that's not worth caching
+    if (!ttl_ms || !capacity || !name || !name[0])
+        return resolve(name, family, entry);
+
+    pthread_mutex_lock(&mutex);
+
+    uint64_t now = now_ms();
+    int index = find_locked((const char *)name, family);
+
+    if (index >= 0 && entries[index].expires_ms > now)
+    {
+        struct cache_entry *cached = &entries[index];
+        cached->last_used_ms = now;
+
+        // The PAL leaves the entry empty when a name doesn't resolve
+        int32_t result = cached->result;
+        if (result)
+            memset(entry, 0, sizeof(HostEntry));
+
+        bool copied = result != 0 || copy_host(entry, &cached->host);
+        if (copied)
+        {
+            if (result)
+                stats.negative_hits++;
+            else
+                stats.hits++;
+        }
+
+        pthread_mutex_unlock(&mutex);
+
+        if (copied)
+            return result;
+
+        // Out of memory for the copy, let the resolver try
+        return resolve(name, family, entry);
+    }
+
+    if (index >= 0)
+        remove_locked(index);
+
+    stats.misses++;
+    pthread_mutex_unlock(&mutex);
+
+    // Concurrent misses for the same name all resolve it, the last one to finish stays in the cache
+    int32_t result = resolve(name, family, entry);
+
+    uint64_t ttl = result == 0 ? ttl_ms : result == DNS_RESULT_NONAME ? negative_ttl_ms : 0;
+    if (!ttl)
+        return result;
+
+    struct cache_entry added = { 0 };
+    added.family = family;
+    added.result = result;
+
+    if (!(added.name = strdup((const char *)name)) || (result == 0 && !copy_host(&added.host, entry)))
+    {
+        free(added.name);
+        return result;
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    now = now_ms();
+    added.expires_ms = now + ttl;
+    added.last_used_ms = now;
+
+    index = find_locked((const char *)name, family);
+    if (index >= 0)
+        remove_locked(index);
+    else if (count >= capacity)
+        evict_locked(now);
+
+    entries[count++] = added;
+
+    pthread_mutex_unlock(&mutex);
+    return result;
+}
+
+void dns_cache_get_stats(struct DnsCacheStats *result)
+{
+    pthread_mutex_lock(&mutex);
+    *result = stats;
+    result->entries = count;
+    result->capacity = capacity;
+    pthread_mutex_unlock(&mutex);
+}
+
+void dns_cache_clear()
+{
+    pthread_mutex_lock(&mutex);
+    while (count)
+        remove_locked(count - 1);
+    pthread_mutex_unlock(&mutex);
+}
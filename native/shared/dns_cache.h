@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// Cache in front of SystemNative_GetHostEntryForName, every new connection to a host name would otherwise ask the sfdnsres service again.
+// Results are kept for a fixed time since getaddrinfo doesn't tell the record TTL, names that don't exist are cached for a shorter time.
+// The resolver is passed in so the cache can be tested without the PAL.
+
+// Same layout as IPAddress in pal_networking.h
+typedef struct
+{
+    uint8_t Address[16];
+    uint32_t IsIPv6;
+    uint32_t ScopeId;
+} IPAddress;
+
+// Same layout as HostEntry in pal_networking.h, every pointer is a separate allocation released by SystemNative_FreeHostEntry
+typedef struct
+{
+    uint8_t* CanonicalName;
+    uint8_t** Aliases;
+    int32_t AliasCount;
+    IPAddress* IPAddressList;
+    int32_t IPAddressCount;
+} HostEntry;
+
+// Same value as PAL_EAI_NONAME, the only error that is cached. The others may be temporary
+#define DNS_RESULT_NONAME 5
+
+// Also exported to managed code through __Internal, keep the layout stable
+struct DnsCacheStats
+{
+    uint64_t hits;
+    uint64_t negative_hits;
+    uint64_t misses;
+    uint64_t evictions;
+    int32_t entries;
+    int32_t capacity;
+};
+
+typedef int32_t (*dns_resolve_fn)(const uint8_t *name, int32_t family, HostEntry *entry);
+
+// ttl_seconds 0 disables the cache
+void dns_cache_configure(int ttl_seconds, int negative_ttl_seconds, int max_entries);
+
+// Returns a cached copy or calls resolve and caches what it returns, the result is released by the caller as usual
+int32_t dns_cache_resolve(const uint8_t *name, int32_t family, HostEntry *entry, dns_resolve_fn resolve);
+
+void dns_cache_get_stats(struct DnsCacheStats *stats);
+
+// Drops all the cached names, the counters are kept
+void dns_cache_clear();
@@ -0,0 +1,727 @@
+#include "io_cache.h"
+#include "io_dircache.h"
+#include "io_util.h"
+#include "profiler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include <switch.h>
+
+// Mono and the BCL read assemblies with many small reads, each of them is an fs IPC round trip on the sd card.
+// We replace the device's devoptab with a copy whose file operations go through a shared LRU of large blocks.
+// The cached files are opened read-only so the blocks never need to be written back, opening a cached path for writing or
+// deleting/renaming it drops its blocks.
+// The same wrapper answers path probes (stat and opening missing files) from the snapshots in io_dircache.c
+
+#define MAX_CACHED_PATHS 8
+
+// Header we put in front of the wrapped device's fileStruct, newlib allocates structSize bytes for us
+typedef struct
+{
+    bool cached;
+    u64 file_id;
+    off_t pos;
+    off_t size;
+    u64 last_block;
+} __attribute__((aligned(16))) cached_file_t;
+
+#define INNER_FILE(f) ((void *)((u8 *)(f) + sizeof(cached_file_t)))
+
+typedef struct cache_block
+{
+    bool valid;
+    u64 file_id;
+    u64 index;
+    size_t length;
+    u8 *data;
+    struct cache_block *lru_prev, *lru_next;
+    struct cache_block *hash_next;
+} cache_block_t;
+
+static bool installed = false;
+static const devoptab_t *inner;
+static devoptab_t wrapper;
+
+static struct IoCacheOptions opts;
+static cache_block_t *blocks;
+static cache_block_t **buckets;
+static size_t bucket_count;
+// Head is the most recently used block
+static cache_block_t *lru_head, *lru_tail;
+static u8 *staging;
+
+static char *cached_paths[MAX_CACHED_PATHS];
+static int cached_path_count = 0;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct
+{
+    u64 files;
+    u64 hits;
+    u64 misses;
+    u64 requested_bytes;
+    u64 device_reads;
+    u64 device_bytes;
+    u64 bypass_bytes;
+    u64 evictions;
+} stats;
+
+static u64 hash_path(const char *path)
+{
+    // FNV-1a
+    u64 hash = 0xcbf29ce484222325ULL;
+    for (; *path; path++)
+    {
+        hash ^= (u8)*path;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Strips the device prefix and resolves relative paths against the cwd, returns false if the path is on another device
+static bool normalize_path(const char *path, char *out, size_t size)
+{
+    const char *colon = strchr(path, ':');
+    if (colon)
+    {
+        if (strncmp(path, inner->name, colon - path) != 0 || strlen(inner->name) != (size_t)(colon - path))
+            return false;
+
+        path = colon + 1;
+    }
+
+    if (path[0] == '/')
+    {
+        snprintf(out, size, "%s", path);
+        return true;
+    }
+
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd)))
+        return false;
+
+    char *cwd_path = strchr(cwd, ':');
+    cwd_path = cwd_path ? cwd_path + 1 : cwd;
+
+    size_t len = strlen(cwd_path);
+    snprintf(out, size, "%s%s%s", cwd_path, (len && cwd_path[len - 1] == '/') ? "" : "/", path);
+    return true;
+}
+
+static bool is_cached_path(const char *path)
+{
+    for (int i = 0; i < cached_path_count; i++)
+    {
+        size_t len = strlen(cached_paths[i]);
+        if (strncmp(path, cached_paths[i], len) == 0 && (path[len] == '/' || path[len] == '\0'))
+            return true;
+    }
+
+    return false;
+}
+
+static size_t bucket_of(u64 file_id, u64 index)
+{
+    return (file_id ^ (index * 0x9E3779B97F4A7C15ULL)) % bucket_count;
+}
+
+static void lru_unlink(cache_block_t *b)
+{
+    if (b->lru_prev) b->lru_prev->lru_next = b->lru_next;
+    else lru_head = b->lru_next;
+
+    if (b->lru_next) b->lru_next->lru_prev = b->lru_prev;
+    else lru_tail = b->lru_prev;
+
+    b->lru_prev = b->lru_next = NULL;
+}
+
+static void lru_push_front(cache_block_t *b)
+{
+    b->lru_prev = NULL;
+    b->lru_next = lru_head;
+
+    if (lru_head) lru_head->lru_prev = b;
+    lru_head = b;
+
+    if (!lru_tail) lru_tail = b;
+}
+
+static void lru_push_back(cache_block_t *b)
+{
+    b->lru_next = NULL;
+    b->lru_prev = lru_tail;
+
+    if (lru_tail) lru_tail->lru_next = b;
+    lru_tail = b;
+
+    if (!lru_head) lru_head = b;
+}
+
+static void hash_remove(cache_block_t *b)
+{
+    cache_block_t **it = &buckets[bucket_of(b->file_id, b->index)];
+    while (*it)
+    {
+        if (*it == b)
+        {
+            *it = b->hash_next;
+            break;
+        }
+        it = &(*it)->hash_next;
+    }
+
+    b->hash_next = NULL;
+    b->valid = false;
+}
+
+static cache_block_t *lookup(u64 file_id, u64 index)
+{
+    for (cache_block_t *b = buckets[bucket_of(file_id, index)]; b; b = b->hash_next)
+    {
+        if (b->file_id == file_id && b->index == index)
+            return b;
+    }
+
+    return NULL;
+}
+
+static void invalidate_file(u64 file_id)
+{
+    pthread_mutex_lock(&cache_lock);
+
+    for (size_t i = 0; i < opts.block_count; i++)
+    {
+        cache_block_t *b = &blocks[i];
+        if (b->valid && b->file_id == file_id)
+        {
+            hash_remove(b);
+            // Move to the back so it's reused first
+            lru_unlink(b);
+            lru_push_back(b);
+        }
+    }
+
+    pthread_mutex_unlock(&cache_lock);
+}
+
+// Reads len bytes at offset from the wrapped device, returns the amount read or -1
+static ssize_t device_read(struct _reent *r, cached_file_t *file, off_t offset, u8 *dest, size_t len)
+{
+    if (inner->seek_r(r, INNER_FILE(file), offset, SEEK_SET) < 0)
+        return -1;
+
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t res = inner->read_r(r, INNER_FILE(file), (char *)dest + done, len - done);
+        stats.device_reads++;
+
+        if (res < 0)
+            return done ? (ssize_t)done : -1;
+        if (res == 0)
+            break;
+
+        done += res;
+    }
+
+    stats.device_bytes += done;
+    return done;
+}
+
+// Loads count consecutive blocks starting at index with a single device read, returns the first block
+static cache_block_t *load_blocks(struct _reent *r, cached_file_t *file, u64 index, size_t count)
+{
+    off_t offset = (off_t)(index * opts.block_size);
+    size_t len = count * opts.block_size;
+
+    if (offset + (off_t)len > file->size)
+        len = file->size - offset;
+
+    ssize_t res = device_read(r, file, offset, staging, len);
+    if (res <= 0)
+        return NULL;
+
+    cache_block_t *first = NULL;
+    for (size_t i = 0; i * opts.block_size < (size_t)res; i++)
+    {
+        cache_block_t *b = lru_tail;
+        if (b->valid)
+        {
+            hash_remove(b);
+            stats.evictions++;
+        }
+
+        size_t block_len = res - i * opts.block_size;
+        if (block_len > opts.block_size)
+            block_len = opts.block_size;
+
+        memcpy(b->data, staging + i * opts.block_size, block_len);
+        b->file_id = file->file_id;
+        b->index = index + i;
+        b->length = block_len;
+        b->valid = true;
+
+        size_t bucket = bucket_of(b->file_id, b->index);
+        b->hash_next = buckets[bucket];
+        buckets[bucket] = b;
+
+        lru_unlink(b);
+        lru_push_front(b);
+
+        if (!first)
+            first = b;
+    }
+
+    return first;
+}
+
+static ssize_t cached_read(struct _reent *r, cached_file_t *file, char *ptr, size_t len)
+{
+    pthread_mutex_lock(&cache_lock);
+
+    if (file->pos >= file->size)
+    {
+        pthread_mutex_unlock(&cache_lock);
+        return 0;
+    }
+
+    if ((off_t)len > file->size - file->pos)
+        len = file->size - file->pos;
+
+    size_t done = 0;
+    bool failed = false;
+    while (done < len)
+    {
+        u64 index = file->pos / opts.block_size;
+        size_t in_block = file->pos % opts.block_size;
+        size_t remaining = len - done;
+
+        cache_block_t *b = lookup(file->file_id, index);
+
+        // Reads of whole blocks don't benefit from the cache, send them straight to the caller's buffer
+        if (!b && in_block == 0 && remaining >= opts.block_size)
+        {
+            size_t direct = remaining - remaining % opts.block_size;
+            ssize_t res = device_read(r, file, file->pos, (u8 *)ptr + done, direct);
+            if (res <= 0)
+            {
+                failed = res < 0;
+                break;
+            }
+
+            stats.bypass_bytes += res;
+            done += res;
+            file->pos += res;
+            file->last_block = (file->pos - 1) / opts.block_size;
+            continue;
+        }
+
+        if (b)
+        {
+            stats.hits++;
+            lru_unlink(b);
+            lru_push_front(b);
+        }
+        else
+        {
+            stats.misses++;
+
+            // Read ahead only when the file is being read sequentially, stop at blocks that are already cached
+            size_t count = 1;
+            if (index == file->last_block + 1)
+            {
+                while (count < opts.readahead_blocks && !lookup(file->file_id, index + count))
+                    count++;
+            }
+
+            b = load_blocks(r, file, index, count);
+            if (!b)
+            {
+                failed = true;
+                break;
+            }
+        }
+
+        if (b->length <= in_block)
+            break;
+
+        size_t n = b->length - in_block;
+        if (n > remaining)
+            n = remaining;
+
+        memcpy(ptr + done, b->data + in_block, n);
+        done += n;
+        file->pos += n;
+        file->last_block = index;
+    }
+
+    stats.requested_bytes += done;
+    pthread_mutex_unlock(&cache_lock);
+
+    if (done == 0 && failed)
+        return -1; // errno was set by the device
+
+    return done;
+}
+
+static int wrap_open(struct _reent *r, void *fileStruct, const char *path, int flags, int mode)
+{
+    cached_file_t *file = fileStruct;
+    memset(file, 0, sizeof(*file));
+
+    char normalized[PATH_MAX];
+    bool is_local = normalize_path(path, normalized, sizeof(normalized));
+
+    if (is_local)
+    {
+        if ((flags & O_ACCMODE) != O_RDONLY || (flags & O_CREAT))
+            io_dircache_invalidate(normalized);
+        else if (io_dircache_lookup(normalized) == IoDirCache_Missing)
+        {
+            io_dircache_count_open();
+            r->_errno = ENOENT;
+            return -1;
+        }
+    }
+
+    int res = inner->open_r(r, INNER_FILE(file), path, flags, mode);
+    if (res < 0)
+        return res;
+
+    if (!is_local || !blocks || !is_cached_path(normalized))
+        return res;
+
+    u64 file_id = hash_path(normalized);
+
+    if ((flags & O_ACCMODE) != O_RDONLY)
+    {
+        invalidate_file(file_id);
+        return res;
+    }
+
+    struct stat st;
+    if (inner->fstat_r(r, INNER_FILE(file), &st) < 0)
+        return res;
+
+    file->cached = true;
+    file->file_id = file_id;
+    file->pos = 0;
+    file->size = st.st_size;
+    file->last_block = (u64)-1;
+
+    stats.files++;
+    return res;
+}
+
+static int wrap_close(struct _reent *r, void *fd)
+{
+    return inner->close_r(r, INNER_FILE(fd));
+}
+
+static ssize_t wrap_write(struct _reent *r, void *fd, const char *ptr, size_t len)
+{
+    return inner->write_r(r, INNER_FILE(fd), ptr, len);
+}
+
+static ssize_t wrap_read(struct _reent *r, void *fd, char *ptr, size_t len)
+{
+    cached_file_t *file = fd;
+    if (!file->cached)
+        return inner->read_r(r, INNER_FILE(file), ptr, len);
+
+    return cached_read(r, file, ptr, len);
+}
+
+static off_t wrap_seek(struct _reent *r, void *fd, off_t pos, int dir)
+{
+    cached_file_t *file = fd;
+    if (!file->cached)
+        return inner->seek_r(r, INNER_FILE(file), pos, dir);
+
+    off_t base;
+    switch (dir)
+    {
+    case SEEK_SET: base = 0; break;
+    case SEEK_CUR: base = file->pos; break;
+    case SEEK_END: base = file->size; break;
+    default:
+        r->_errno = EINVAL;
+        return -1;
+    }
+
+    if (base + pos < 0)
+    {
+        r->_errno = EINVAL;
+        return -1;
+    }
+
+    file->pos = base + pos;
+    return file->pos;
+}
+
+static int wrap_fstat(struct _reent *r, void *fd, struct stat *st)
+{
+    return inner->fstat_r(r, INNER_FILE(fd), st);
+}
+
+static int wrap_ftruncate(struct _reent *r, void *fd, off_t len)
+{
+    return inner->ftruncate_r(r, INNER_FILE(fd), len);
+}
+
+static int wrap_fsync(struct _reent *r, void *fd)
+{
+    return inner->fsync_r(r, INNER_FILE(fd));
+}
+
+static int wrap_fchmod(struct _reent *r, void *fd, mode_t mode)
+{
+    return inner->fchmod_r(r, INNER_FILE(fd), mode);
+}
+
+static long wrap_fpathconf(struct _reent *r, void *fd, int name)
+{
+    return inner->fpathconf_r(r, INNER_FILE(fd), name);
+}
+
+static void invalidate_path(const char *path)
+{
+    char normalized[PATH_MAX];
+    if (!normalize_path(path, normalized, sizeof(normalized)))
+        return;
+
+    io_dircache_invalidate(normalized);
+
+    if (blocks && is_cached_path(normalized))
+        invalidate_file(hash_path(normalized));
+}
+
+// Missing paths are answered from the snapshot, the others need the attributes and times from the device
+static bool probe_missing(struct _reent *r, const char *path)
+{
+    char normalized[PATH_MAX];
+    if (!normalize_path(path, normalized, sizeof(normalized)) || io_dircache_lookup(normalized) != IoDirCache_Missing)
+        return false;
+
+    io_dircache_count_stat();
+    r->_errno = ENOENT;
+    return true;
+}
+
+static int wrap_stat(struct _reent *r, const char *file, struct stat *st)
+{
+    return probe_missing(r, file) ? -1 : inner->stat_r(r, file, st);
+}
+
+static int wrap_lstat(struct _reent *r, const char *file, struct stat *st)
+{
+    return probe_missing(r, file) ? -1 : inner->lstat_r(r, file, st);
+}
+
+static int wrap_mkdir(struct _reent *r, const char *path, int mode)
+{
+    invalidate_path(path);
+    return inner->mkdir_r(r, path, mode);
+}
+
+static int wrap_rmdir(struct _reent *r, const char *name)
+{
+    invalidate_path(name);
+    return inner->rmdir_r(r, name);
+}
+
+static int wrap_unlink(struct _reent *r, const char *name)
+{
+    invalidate_path(name);
+    return inner->unlink_r(r, name);
+}
+
+static int wrap_rename(struct _reent *r, const char *oldName, const char *newName)
+{
+    invalidate_path(oldName);
+    invalidate_path(newName);
+    return inner->rename_r(r, oldName, newName);
+}
+
+static void io_cache_report()
+{
+    u64 lookups = stats.hits + stats.misses;
+    io_debugf("read cache: %llu files, %llu hits, %llu misses (%.1f%% hit rate), %llu evictions",
+        (unsigned long long)stats.files, (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+        lookups ? stats.hits * 100.0 / lookups : 0.0, (unsigned long long)stats.evictions);
+    io_debugf("read cache: %llu KB requested, %llu KB read from device in %llu reads (%llu KB bypassed the cache)",
+        (unsigned long long)stats.requested_bytes / 1024, (unsigned long long)stats.device_bytes / 1024,
+        (unsigned long long)stats.device_reads, (unsigned long long)stats.bypass_bytes / 1024);
+}
+
+static bool allocate_blocks()
+{
+    // A single read ahead must never evict the blocks it just loaded
+    if (opts.readahead_blocks < 1)
+        opts.readahead_blocks = 1;
+    if (opts.readahead_blocks > opts.block_count / 2)
+        opts.readahead_blocks = opts.block_count / 2;
+
+    blocks = calloc(opts.block_count, sizeof(cache_block_t));
+    bucket_count = opts.block_count * 2;
+    buckets = calloc(bucket_count, sizeof(cache_block_t *));
+    staging = malloc(opts.block_size * opts.readahead_blocks);
+    u8 *block_data = malloc(opts.block_size * opts.block_count);
+
+    if (!blocks || !buckets || !staging || !block_data)
+    {
+        free(blocks);
+        free(buckets);
+        free(staging);
+        free(block_data);
+        blocks = NULL;
+        buckets = NULL;
+        staging = NULL;
+        return false;
+    }
+
+    for (size_t i = 0; i < opts.block_count; i++)
+    {
+        blocks[i].data = block_data + i * opts.block_size;
+        lru_push_front(&blocks[i]);
+    }
+
+    return true;
+}
+
+bool io_cache_install(const char *device_name, const struct IoCacheOptions *options)
+{
+    if (installed)
+        return false;
+
+    // A block_count of 0 installs the wrapper for the probe cache only
+    if (options->block_count && (!options->block_size || options->block_count < 2))
+        return false;
+
+    char lookup_name[32];
+    snprintf(lookup_name, sizeof(lookup_name), "%s:", device_name);
+
+    int index = FindDevice(lookup_name);
+    if (index < 0 || !devoptab_list[index])
+        return false;
+
+    opts = *options;
+
+    if (opts.block_count && !allocate_blocks())
+        return false;
+
+    inner = devoptab_list[index];
+
+    wrapper = *inner;
+    wrapper.structSize = sizeof(cached_file_t) + inner->structSize;
+    wrapper.open_r = wrap_open;
+    wrapper.close_r = wrap_close;
+    wrapper.write_r = inner->write_r ? wrap_write : NULL;
+    wrapper.read_r = wrap_read;
+    wrapper.seek_r = wrap_seek;
+    wrapper.fstat_r = wrap_fstat;
+    wrapper.ftruncate_r = inner->ftruncate_r ? wrap_ftruncate : NULL;
+    wrapper.fsync_r = inner->fsync_r ? wrap_fsync : NULL;
+    wrapper.fchmod_r = inner->fchmod_r ? wrap_fchmod : NULL;
+    wrapper.fpathconf_r = inner->fpathconf_r ? wrap_fpathconf : NULL;
+    wrapper.unlink_r = inner->unlink_r ? wrap_unlink : NULL;
+    wrapper.rename_r = inner->rename_r ? wrap_rename : NULL;
+    wrapper.stat_r = inner->stat_r ? wrap_stat : NULL;
+    wrapper.lstat_r = inner->lstat_r ? wrap_lstat : NULL;
+    wrapper.mkdir_r = inner->mkdir_r ? wrap_mkdir : NULL;
+    wrapper.rmdir_r = inner->rmdir_r ? wrap_rmdir : NULL;
+
+    devoptab_list[index] = &wrapper;
+    installed = true;
+
+    if (blocks)
+        profiler_register_report(io_cache_report);
+
+    return true;
+}
+
+// Calls fn for each path in a ; separated list, with the device prefix and trailing slashes stripped so matching works on whole path components
+static void for_each_path(const char *paths, void (*fn)(const char *path))
+{
+    if (!paths)
+        return;
+
+    char *copy = io_strdup(paths);
+    char *saveptr = NULL;
+
+    for (char *tok = strtok_r(copy, ";", &saveptr); tok; tok = strtok_r(NULL, ";", &saveptr))
+    {
+        char *colon = strchr(tok, ':');
+        if (colon)
+        {
+            // Paths on other devices (romfs) never go through the wrapper
+            *colon = '\0';
+            if (strcmp(tok, inner->name) != 0)
+                continue;
+
+            tok = colon + 1;
+        }
+
+        size_t len = strlen(tok);
+        while (len > 1 && tok[len - 1] == '/')
+            tok[--len] = '\0';
+
+        if (len == 0 || tok[0] != '/')
+            continue;
+
+        fn(tok);
+    }
+
+    free(copy);
+}
+
+static void add_cached_path(const char *path)
+{
+    if (cached_path_count >= MAX_CACHED_PATHS)
+    {
+        io_debugf("read cache: too many paths, ignoring %s", path);
+        return;
+    }
+
+    cached_paths[cached_path_count++] = io_strdup(path);
+}
+
+void io_cache_add_paths(const char *paths)
+{
+    if (!blocks)
+        return;
+
+    for_each_path(paths, add_cached_path);
+}
+
+static void add_probe_path(const char *path)
+{
+    if (!io_dircache_snapshot(_REENT, inner, path))
+        io_debugf("probe cache: failed to read %s", path);
+}
+
+void io_cache_add_probe_paths(const char *paths)
+{
+    if (!installed)
+        return;
+
+    for_each_path(paths, add_probe_path);
+}
+
+const devoptab_t *io_cache_unwrap(const devoptab_t *dev, void **file_struct)
+{
+    if (!installed || dev != &wrapper)
+        return dev;
+
+    *file_struct = INNER_FILE(*file_struct);
+    return inner;
+}
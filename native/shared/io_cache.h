@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/iosupport.h>
+
+// Read-ahead block cache that sits under a newlib device (sdmc).
+// Only files opened read-only under one of the registered path prefixes go through the cache, everything else is passed to the real device.
+// The wrapper also answers stat() and open() probes for the folders added with io_cache_add_probe_paths, see io_dircache.h
+
+struct IoCacheOptions
+{
+    size_t block_size;
+    // 0 disables the block cache, only the probe cache is used
+    size_t block_count;
+    // Number of blocks fetched with a single read when the access pattern is sequential
+    size_t readahead_blocks;
+};
+
+// Wraps the device in devoptab_list, must be called before any file on that device is opened.
+// The wrapper stays installed for the lifetime of the process since we can't tell which open handles still reference it.
+bool io_cache_install(const char *device_name, const struct IoCacheOptions *options);
+
+// Adds a list of ; separated path prefixes to the cached set, paths are relative to the wrapped device
+void io_cache_add_paths(const char *paths);
+
+// If dev is the cache wrapper, returns the wrapped device and replaces file_struct with the wrapped device's file.
+// Otherwise returns dev as is.
+const devoptab_t *io_cache_unwrap(const devoptab_t *dev, void **file_struct);
+
+// Snapshots the listing of each folder in a ; separated list, stat() and failed open() calls for their direct children are answered from memory.
+// Must be called before other threads use the device.
+void io_cache_add_probe_paths(const char *paths);
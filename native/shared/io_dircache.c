@@ -0,0 +1,271 @@
+#include "io_dircache.h"
+#include "io_util.h"
+#include "profiler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+
+#include <switch.h>
+
+// The sd card filesystem is case insensitive so names are hashed and compared ignoring case,
+// otherwise a probe with a different casing would be answered as missing while the device would find the file.
+
+#define MAX_SNAPSHOT_DIRS 8
+
+typedef struct
+{
+    char *path;
+    size_t len;
+    // Cleared when something in the folder changes, from then on its lookups go to the device
+    volatile bool valid;
+} snapshot_dir_t;
+
+typedef struct
+{
+    char *path;
+    u64 hash;
+    int next;
+} snapshot_entry_t;
+
+static snapshot_dir_t dirs[MAX_SNAPSHOT_DIRS];
+static int dir_count = 0;
+
+static snapshot_entry_t *entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+
+static int *buckets = NULL;
+static size_t bucket_count = 0;
+
+static bool report_registered = false;
+
+static struct
+{
+    u64 listing_reads;
+    u64 stat_missing;
+    u64 open_missing;
+    u64 fallbacks;
+} stats;
+
+static u64 hash_path_nocase(const char *path)
+{
+    // FNV-1a
+    u64 hash = 0xcbf29ce484222325ULL;
+    for (; *path; path++)
+    {
+        hash ^= (u8)tolower((u8)*path);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void rebuild_buckets()
+{
+    size_t count = 64;
+    while (count < (size_t)entry_count * 2)
+        count *= 2;
+
+    int *new_buckets = malloc(count * sizeof(int));
+    if (!new_buckets)
+        return;
+
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = count;
+
+    for (size_t i = 0; i < bucket_count; i++)
+        buckets[i] = -1;
+
+    for (int i = 0; i < entry_count; i++)
+    {
+        size_t bucket = entries[i].hash & (bucket_count - 1);
+        entries[i].next = buckets[bucket];
+        buckets[bucket] = i;
+    }
+}
+
+static bool add_entry(const char *dir, const char *name)
+{
+    if (entry_count == entry_capacity)
+    {
+        int capacity = entry_capacity ? entry_capacity * 2 : 256;
+        snapshot_entry_t *grown = realloc(entries, capacity * sizeof(snapshot_entry_t));
+        if (!grown)
+            return false;
+
+        entries = grown;
+        entry_capacity = capacity;
+    }
+
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char *path = malloc(len);
+    if (!path)
+        return false;
+
+    snprintf(path, len, "%s/%s", dir, name);
+
+    snapshot_entry_t *entry = &entries[entry_count++];
+    entry->path = path;
+    entry->hash = hash_path_nocase(path);
+    entry->next = -1;
+    return true;
+}
+
+static void io_dircache_report()
+{
+    u64 avoided = stats.stat_missing + stats.open_missing;
+    io_debugf("probe cache: %d entries in %d folders read with %llu listing calls",
+        entry_count, dir_count, (unsigned long long)stats.listing_reads);
+    io_debugf("probe cache: %llu fs calls avoided (%llu stat misses, %llu failed opens), %llu lookups fell back to the device",
+        (unsigned long long)avoided, (unsigned long long)stats.stat_missing,
+        (unsigned long long)stats.open_missing, (unsigned long long)stats.fallbacks);
+}
+
+bool io_dircache_snapshot(struct _reent *r, const devoptab_t *dev, const char *dir)
+{
+    if (dir_count >= MAX_SNAPSHOT_DIRS)
+    {
+        io_debugf("probe cache: too many folders, ignoring %s", dir);
+        return false;
+    }
+
+    if (!dev->diropen_r || !dev->dirnext_r || !dev->dirclose_r)
+        return false;
+
+    DIR_ITER iter = { 0 };
+    iter.dirStruct = calloc(1, dev->dirStateSize);
+    if (!iter.dirStruct)
+        return false;
+
+    char device_path[PATH_MAX];
+    snprintf(device_path, sizeof(device_path), "%s:%s", dev->name, dir);
+
+    if (!dev->diropen_r(r, &iter, device_path))
+    {
+        free(iter.dirStruct);
+        return false;
+    }
+
+    int first_entry = entry_count;
+    bool ok = true;
+
+    char name[PATH_MAX];
+    struct stat st;
+    while (dev->dirnext_r(r, &iter, name, &st) == 0)
+    {
+        stats.listing_reads++;
+
+        if (!strcmp(name, ".") || !strcmp(name, ".."))
+            continue;
+
+        if (!add_entry(dir, name))
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    dev->dirclose_r(r, &iter);
+    free(iter.dirStruct);
+
+    if (!ok)
+    {
+        // Drop the partial listing, a folder is either fully known or not known at all
+        for (int i = first_entry; i < entry_count; i++)
+            free(entries[i].path);
+        entry_count = first_entry;
+        return false;
+    }
+
+    snapshot_dir_t *snapshot = &dirs[dir_count];
+    snapshot->path = io_strdup(dir);
+    snapshot->len = strlen(dir);
+    snapshot->valid = true;
+    dir_count++;
+
+    rebuild_buckets();
+
+    if (!report_registered)
+    {
+        profiler_register_report(io_dircache_report);
+        report_registered = true;
+    }
+
+    io_debugf("probe cache: %s has %d entries", dir, entry_count - first_entry);
+    return true;
+}
+
+// Returns the snapshot of the folder that directly contains path
+static snapshot_dir_t *find_parent(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    if (!slash)
+        return NULL;
+
+    size_t len = slash - path;
+    for (int i = 0; i < dir_count; i++)
+    {
+        if (dirs[i].len == len && strncasecmp(dirs[i].path, path, len) == 0)
+            return &dirs[i];
+    }
+
+    return NULL;
+}
+
+enum IoDirCacheResult io_dircache_lookup(const char *path)
+{
+    if (!buckets)
+        return IoDirCache_Unknown;
+
+    snapshot_dir_t *dir = find_parent(path);
+    if (!dir || !dir->valid)
+    {
+        if (dir)
+            __atomic_add_fetch(&stats.fallbacks, 1, __ATOMIC_RELAXED);
+        return IoDirCache_Unknown;
+    }
+
+    u64 hash = hash_path_nocase(path);
+    for (int i = buckets[hash & (bucket_count - 1)]; i >= 0; i = entries[i].next)
+    {
+        if (entries[i].hash == hash && strcasecmp(entries[i].path, path) == 0)
+            return IoDirCache_Found;
+    }
+
+    return IoDirCache_Missing;
+}
+
+void io_dircache_count_stat()
+{
+    __atomic_add_fetch(&stats.stat_missing, 1, __ATOMIC_RELAXED);
+}
+
+void io_dircache_count_open()
+{
+    __atomic_add_fetch(&stats.open_missing, 1, __ATOMIC_RELAXED);
+}
+
+void io_dircache_invalidate(const char *path)
+{
+    size_t len = strlen(path);
+
+    for (int i = 0; i < dir_count; i++)
+    {
+        snapshot_dir_t *dir = &dirs[i];
+        if (!dir->valid)
+            continue;
+
+        // Either path is an entry of the folder or it's the folder itself (or one of its parents) being removed or renamed
+        bool parent = find_parent(path) == dir;
+        bool ancestor = len <= dir->len && strncasecmp(dir->path, path, len) == 0 && (dir->path[len] == '/' || dir->path[len] == '\0');
+
+        if (parent || ancestor)
+        {
+            io_debugf("probe cache: %s changed, no longer using its snapshot", dir->path);
+            dir->valid = false;
+        }
+    }
+}
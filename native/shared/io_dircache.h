@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <sys/stat.h>
+#include <sys/iosupport.h>
+
+// In-memory snapshot of directory listings used to answer stat() and failed open() probes without an fs IPC round trip.
+// Mono probes every assembly_dir folder for each referenced assembly, most of these probes are misses.
+// Only the direct children of a snapshotted folder are covered, every other path is reported as unknown and must go to the device.
+// Paths are device-relative and already normalized, see normalize_path in io_cache.c
+
+enum IoDirCacheResult
+{
+    IoDirCache_Unknown,
+    IoDirCache_Missing,
+    IoDirCache_Found,
+};
+
+// Reads the whole listing of dir from dev, must be called before other threads start using the device
+bool io_dircache_snapshot(struct _reent *r, const devoptab_t *dev, const char *dir);
+
+// Only answers whether the path exists. The listing has no timestamps or permissions, stat of a path that exists still goes to the device
+enum IoDirCacheResult io_dircache_lookup(const char *path);
+
+// Record that a stat() or an open() was answered by the snapshot, only used for the report
+void io_dircache_count_stat();
+void io_dircache_count_open();
+
+// Stops using the snapshot of the folder that contains path, call this when an entry is created, removed or renamed
+void io_dircache_invalidate(const char *path);
@@ -0,0 +1,230 @@
+#include "io_dirread.h"
+#include "io_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include <switch.h>
+
+// Number of entries fetched with a single fsDirRead, each entry is 0x310 bytes
+#define STAGED_ENTRY_COUNT 64
+
+#define RECORD_ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+typedef struct
+{
+    bool native;
+
+    // fsdev devices
+    FsDir dir;
+    FsDirectoryEntry *staged;
+    s64 staged_count;
+    s64 staged_pos;
+
+    // Everything else (romfs) goes through readdir and a stat per entry
+    DIR *fallback;
+    char path[PATH_MAX];
+    // Entry that didn't fit in the previous call's buffer
+    bool has_pending;
+    char pending[NAME_MAX + 1];
+} dir_handle_t;
+
+static bool write_record(u8 *buffer, size_t buffer_size, size_t *offset, const char *name, u32 type, s64 size)
+{
+    size_t name_length = strlen(name);
+    size_t record_size = RECORD_ALIGN(sizeof(struct DirReadEntry) + name_length);
+
+    if (*offset + record_size > buffer_size)
+        return false;
+
+    struct DirReadEntry *entry = (struct DirReadEntry *)(buffer + *offset);
+    entry->size = size;
+    entry->type = type;
+    entry->name_length = (u32)name_length;
+    memcpy(entry->name, name, name_length);
+
+    *offset += record_size;
+    return true;
+}
+
+void *extensionDirOpen(const char *path)
+{
+    dir_handle_t *handle = calloc(1, sizeof(dir_handle_t));
+    if (!handle)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    FsFileSystem *fs = NULL;
+    char fs_path[FS_MAX_PATH];
+
+    if (fsdevTranslatePath(path, &fs, fs_path) != -1 &&
+        R_SUCCEEDED(fsFsOpenDirectory(fs, fs_path, FsDirOpenMode_ReadDirs | FsDirOpenMode_ReadFiles, &handle->dir)))
+    {
+        handle->staged = malloc(STAGED_ENTRY_COUNT * sizeof(FsDirectoryEntry));
+        if (!handle->staged)
+        {
+            fsDirClose(&handle->dir);
+            free(handle);
+            errno = ENOMEM;
+            return NULL;
+        }
+
+        handle->native = true;
+        return handle;
+    }
+
+    // Not an fsdev path or the open failed, opendir will either handle it or set the right errno
+    handle->fallback = opendir(path);
+    if (!handle->fallback)
+    {
+        free(handle);
+        return NULL;
+    }
+
+    snprintf(handle->path, sizeof(handle->path), "%s", path);
+    return handle;
+}
+
+static int32_t read_native(dir_handle_t *handle, u8 *buffer, size_t buffer_size)
+{
+    size_t offset = 0;
+    int32_t count = 0;
+
+    while (true)
+    {
+        if (handle->staged_pos == handle->staged_count)
+        {
+            handle->staged_pos = 0;
+            handle->staged_count = 0;
+
+            Result rc = fsDirRead(&handle->dir, &handle->staged_count, STAGED_ENTRY_COUNT, handle->staged);
+            if (R_FAILED(rc))
+            {
+                io_debugf("fsDirRead failed: %x", rc);
+                if (count)
+                    return count;
+
+                errno = EIO;
+                return -1;
+            }
+
+            if (handle->staged_count == 0)
+                return count;
+        }
+
+        FsDirectoryEntry *entry = &handle->staged[handle->staged_pos];
+        u32 type = entry->type == FsDirEntryType_Dir ? DirReadEntry_Directory : DirReadEntry_File;
+        s64 size = entry->type == FsDirEntryType_Dir ? 0 : entry->file_size;
+
+        // Entries that don't fit stay staged for the next call
+        if (!write_record(buffer, buffer_size, &offset, entry->name, type, size))
+            break;
+
+        handle->staged_pos++;
+        count++;
+    }
+
+    if (count == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return count;
+}
+
+static int32_t read_fallback(dir_handle_t *handle, u8 *buffer, size_t buffer_size)
+{
+    size_t offset = 0;
+    int32_t count = 0;
+
+    while (true)
+    {
+        const char *name;
+        if (handle->has_pending)
+            name = handle->pending;
+        else
+        {
+            struct dirent *ent = readdir(handle->fallback);
+            if (!ent)
+                return count;
+
+            if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+                continue;
+
+            name = ent->d_name;
+        }
+
+        char full_path[PATH_MAX];
+        snprintf(full_path, sizeof(full_path), "%s/%s", handle->path, name);
+
+        struct stat st;
+        u32 type = DirReadEntry_Other;
+        s64 size = -1;
+
+        if (stat(full_path, &st) == 0)
+        {
+            type = S_ISDIR(st.st_mode) ? DirReadEntry_Directory : S_ISREG(st.st_mode) ? DirReadEntry_File : DirReadEntry_Other;
+            size = S_ISDIR(st.st_mode) ? 0 : st.st_size;
+        }
+
+        if (!write_record(buffer, buffer_size, &offset, name, type, size))
+        {
+            if (!handle->has_pending)
+            {
+                snprintf(handle->pending, sizeof(handle->pending), "%s", name);
+                handle->has_pending = true;
+            }
+            break;
+        }
+
+        handle->has_pending = false;
+        count++;
+    }
+
+    if (count == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return count;
+}
+
+int32_t extensionDirRead(void *handle, void *buffer, int32_t buffer_size)
+{
+    dir_handle_t *dir = handle;
+    if (!dir || !buffer || buffer_size <= 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (dir->native)
+        return read_native(dir, buffer, buffer_size);
+    else
+        return read_fallback(dir, buffer, buffer_size);
+}
+
+void extensionDirClose(void *handle)
+{
+    dir_handle_t *dir = handle;
+    if (!dir)
+        return;
+
+    if (dir->native)
+    {
+        fsDirClose(&dir->dir);
+        free(dir->staged);
+    }
+    else
+        closedir(dir->fallback);
+
+    free(dir);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+// Bulk directory listing exported to managed code through the libnx dlshim.
+// The BCL enumerates folders with one SystemNative_ReadDirR call per entry followed by a stat for each file,
+// on fsdev devices we read many entries per fs IPC call and they already carry the type and size.
+
+enum DirReadEntryType
+{
+    DirReadEntry_File = 0,
+    DirReadEntry_Directory = 1,
+    DirReadEntry_Other = 2,
+};
+
+// Records are packed back to back in the caller's buffer, each one starts at an 8 byte aligned offset
+struct DirReadEntry
+{
+    // -1 when the device doesn't report sizes in its listing
+    int64_t size;
+    uint32_t type;
+    // Length in bytes of the UTF-8 name that follows, not zero terminated
+    uint32_t name_length;
+    char name[];
+};
+
+// Returns NULL and sets errno on failure
+void *extensionDirOpen(const char *path);
+
+// Fills buffer with as many records as fit, returns the number of records written, 0 at the end of the listing or -1 with errno set.
+// A buffer of at least 1KB always fits one record.
+int32_t extensionDirRead(void *handle, void *buffer, int32_t buffer_size);
+
+void extensionDirClose(void *handle);
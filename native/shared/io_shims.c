@@ -1,68 +1,346 @@
 #include <_ansi.h>
 #include <unistd.h>
 #include <reent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/iosupport.h>
 
-ssize_t
-_pwrite_r (struct _reent *rptr,
-     int fd,
-     const void *buf,
-     size_t n,
-     off_t off)
+#include <switch.h>
+
+#include "io_cache.h"
+
+// Newlib only provides pread/pwrite as lseek + read + lseek which is three calls per operation and races when multiple threads share the same fd.
+// For fsdev devices (sdmc and anything else mounted with fsdevMountDevice) we bypass the file position entirely and use the offset-based fs API.
+// Other devices such as romfs don't expose their file handles so we keep the seek emulation but serialize it with a lock.
+
+ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t off);
+ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t off);
+
+// Mirror of fsdev_file_t from libnx's fs_dev.c, this is what newlib stores in __handle::fileStruct for fsdev devices.
+// Keep this in sync with libnx when updating the toolchain.
+typedef struct
+{
+    FsFile fd;
+    int flags;
+    s64 offset;
+} fsdev_file_mirror_t;
+
+enum
+{
+    DeviceKind_Unknown = 0,
+    DeviceKind_Fsdev,
+    DeviceKind_Other,
+};
+
+// Devices may be mounted and unmounted at runtime so we remember which devoptab the cached kind belongs to
+static const devoptab_t *device_kind_owner[STD_MAX];
+static int device_kind[STD_MAX];
+
+// Fs IPC refuses buffers outside of the heap (eg. thread stacks), in that case we go through a bounce buffer like fs_dev.c does
+#define FS_ERR_INVALID_BUFFER 0xD401
+#define BOUNCE_BUFFER_SIZE 0x10000
+
+#define FALLBACK_LOCK_COUNT 16
+static pthread_mutex_t fallback_locks[FALLBACK_LOCK_COUNT] = {
+    [0 ... FALLBACK_LOCK_COUNT - 1] = PTHREAD_MUTEX_INITIALIZER
+};
+
+// Returns false if fd is not a valid file descriptor, out_file is set only for fsdev files
+static bool get_fsdev_file(int fd, fsdev_file_mirror_t **out_file)
+{
+    *out_file = NULL;
+
+    __handle *handle = __get_handle(fd);
+    if (!handle)
+        return false;
+
+    int device = handle->device;
+    if (device < 0 || device >= STD_MAX)
+        return true;
+
+    void *file_struct = handle->fileStruct;
+
+    // Files opened through the read cache carry the fsdev file after the cache header, positional I/O goes straight to the device
+    const devoptab_t *dev = io_cache_unwrap(devoptab_list[device], &file_struct);
+    if (!dev)
+        return true;
+
+    if (device_kind_owner[device] != dev || device_kind[device] == DeviceKind_Unknown)
+    {
+        device_kind[device] = fsdevGetDeviceFileSystem(dev->name) ? DeviceKind_Fsdev : DeviceKind_Other;
+        device_kind_owner[device] = dev;
+    }
+
+    if (device_kind[device] == DeviceKind_Fsdev)
+        *out_file = (fsdev_file_mirror_t *)file_struct;
+
+    return true;
+}
+
+static ssize_t fsdev_pread(struct _reent *r, fsdev_file_mirror_t *file, void *buf, size_t n, off_t off)
+{
+    if ((file->flags & O_ACCMODE) == O_WRONLY)
+    {
+        r->_errno = EBADF;
+        return -1;
+    }
+
+    u64 bytes = 0;
+    Result rc = fsFileRead(&file->fd, off, buf, n, FsReadOption_None, &bytes);
+    if (rc == FS_ERR_INVALID_BUFFER)
+    {
+        u8 *bounce = malloc(BOUNCE_BUFFER_SIZE);
+        if (!bounce)
+        {
+            r->_errno = ENOMEM;
+            return -1;
+        }
+
+        bytes = 0;
+        while (bytes < n)
+        {
+            size_t chunk = n - bytes > BOUNCE_BUFFER_SIZE ? BOUNCE_BUFFER_SIZE : n - bytes;
+            u64 chunk_read = 0;
+
+            rc = fsFileRead(&file->fd, off + bytes, bounce, chunk, FsReadOption_None, &chunk_read);
+            if (R_FAILED(rc))
+                break;
+
+            memcpy((u8 *)buf + bytes, bounce, chunk_read);
+            bytes += chunk_read;
+
+            if (chunk_read < chunk)
+                break;
+        }
+
+        free(bounce);
+
+        // Report partial reads as success like read() would
+        if (R_FAILED(rc) && bytes == 0)
+        {
+            r->_errno = EIO;
+            return -1;
+        }
+
+        return (ssize_t)bytes;
+    }
+
+    if (R_FAILED(rc))
+    {
+        r->_errno = EIO;
+        return -1;
+    }
+
+    return (ssize_t)bytes;
+}
+
+static ssize_t fsdev_pwrite(struct _reent *r, fsdev_file_mirror_t *file, const void *buf, size_t n, off_t off)
+{
+    if ((file->flags & O_ACCMODE) == O_RDONLY)
+    {
+        r->_errno = EBADF;
+        return -1;
+    }
+
+    // fs_dev opens writable files with FsOpenMode_Append so writing past the end grows the file
+    Result rc = fsFileWrite(&file->fd, off, buf, n, FsWriteOption_None);
+    if (rc == FS_ERR_INVALID_BUFFER)
+    {
+        u8 *bounce = malloc(BOUNCE_BUFFER_SIZE);
+        if (!bounce)
+        {
+            r->_errno = ENOMEM;
+            return -1;
+        }
+
+        size_t written = 0;
+        while (written < n)
+        {
+            size_t chunk = n - written > BOUNCE_BUFFER_SIZE ? BOUNCE_BUFFER_SIZE : n - written;
+            memcpy(bounce, (const u8 *)buf + written, chunk);
+
+            rc = fsFileWrite(&file->fd, off + written, bounce, chunk, FsWriteOption_None);
+            if (R_FAILED(rc))
+                break;
+
+            written += chunk;
+        }
+
+        free(bounce);
+
+        if (R_FAILED(rc) && written == 0)
+        {
+            r->_errno = EIO;
+            return -1;
+        }
+
+        return (ssize_t)written;
+    }
+
+    if (R_FAILED(rc))
+    {
+        r->_errno = EIO;
+        return -1;
+    }
+
+    return (ssize_t)n;
+}
+
+// Seek emulation for devices we can't do positional I/O on. is_write selects between _read_r and _write_r for each vector.
+static ssize_t fallback_prw(struct _reent *r, int fd, const struct iovec *iov, int iovcnt, off_t off, bool is_write)
 {
-  off_t cur_pos;
-  _READ_WRITE_RETURN_TYPE num_written;
-  
-  if ((cur_pos = _lseek_r (rptr, fd, 0, SEEK_CUR)) == (off_t)-1)
-    return -1;
+    pthread_mutex_t *lock = &fallback_locks[(unsigned)fd % FALLBACK_LOCK_COUNT];
+    pthread_mutex_lock(lock);
+
+    ssize_t total = -1;
+    off_t cur_pos;
 
-  if (_lseek_r (rptr, fd, off, SEEK_SET) == (off_t)-1)
-    return -1;
+    if ((cur_pos = _lseek_r(r, fd, 0, SEEK_CUR)) == (off_t)-1)
+        goto exit;
 
-  num_written = _write_r (rptr, fd, buf, n);
+    if (_lseek_r(r, fd, off, SEEK_SET) == (off_t)-1)
+        goto exit;
 
-  if (_lseek_r (rptr, fd, cur_pos, SEEK_SET) == (off_t)-1)
-    return -1;
+    total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        _READ_WRITE_RETURN_TYPE res = is_write ?
+            _write_r(r, fd, iov[i].iov_base, iov[i].iov_len) :
+            _read_r(r, fd, iov[i].iov_base, iov[i].iov_len);
 
-  return (ssize_t)num_written;
+        if (res < 0)
+        {
+            if (total == 0)
+                total = -1;
+            break;
+        }
+
+        total += res;
+
+        if ((size_t)res < iov[i].iov_len)
+            break;
+    }
+
+    if (_lseek_r(r, fd, cur_pos, SEEK_SET) == (off_t)-1)
+        total = -1;
+
+exit:
+    pthread_mutex_unlock(lock);
+    return total;
 }
 
-ssize_t
-pwrite (int fd,
-     const void *buf,
-     size_t n,
-     off_t off)
+static bool validate_args(struct _reent *r, const struct iovec *iov, int iovcnt, off_t off)
 {
-  return _pwrite_r (_REENT, fd, buf, n, off);
+    if (off < 0 || iovcnt < 0 || (iovcnt > 0 && !iov))
+    {
+        r->_errno = EINVAL;
+        return false;
+    }
+
+    return true;
 }
-ssize_t
-_pread_r (struct _reent *rptr,
-     int fd,
-     void *buf,
-     size_t n,
-     off_t off)
+
+static ssize_t _preadv_r(struct _reent *r, int fd, const struct iovec *iov, int iovcnt, off_t off)
 {
-  off_t cur_pos;
-  _READ_WRITE_RETURN_TYPE num_read;
-  
-  if ((cur_pos = _lseek_r (rptr, fd, 0, SEEK_CUR)) == (off_t)-1)
-    return -1;
+    if (!validate_args(r, iov, iovcnt, off))
+        return -1;
+
+    fsdev_file_mirror_t *file;
+    if (!get_fsdev_file(fd, &file))
+    {
+        r->_errno = EBADF;
+        return -1;
+    }
+
+    if (!file)
+        return fallback_prw(r, fd, iov, iovcnt, off, false);
 
-  if (_lseek_r (rptr, fd, off, SEEK_SET) == (off_t)-1)
-    return -1;
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (iov[i].iov_len == 0)
+            continue;
 
-  num_read = _read_r (rptr, fd, buf, n);
+        ssize_t res = fsdev_pread(r, file, iov[i].iov_base, iov[i].iov_len, off + total);
+        if (res < 0)
+            return total ? total : -1;
 
-  if (_lseek_r (rptr, fd, cur_pos, SEEK_SET) == (off_t)-1)
-    return -1;
+        total += res;
 
-  return (ssize_t)num_read;
+        // Short read means we reached the end of the file
+        if ((size_t)res < iov[i].iov_len)
+            break;
+    }
+
+    return total;
 }
 
-ssize_t
-pread (int fd,
-     void *buf,
-     size_t n,
-     off_t off)
+static ssize_t _pwritev_r(struct _reent *r, int fd, const struct iovec *iov, int iovcnt, off_t off)
 {
-  return _pread_r (_REENT, fd, buf, n, off);
-}
\ No newline at end of file
+    if (!validate_args(r, iov, iovcnt, off))
+        return -1;
+
+    fsdev_file_mirror_t *file;
+    if (!get_fsdev_file(fd, &file))
+    {
+        r->_errno = EBADF;
+        return -1;
+    }
+
+    if (!file)
+        return fallback_prw(r, fd, iov, iovcnt, off, true);
+
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (iov[i].iov_len == 0)
+            continue;
+
+        ssize_t res = fsdev_pwrite(r, file, iov[i].iov_base, iov[i].iov_len, off + total);
+        if (res < 0)
+            return total ? total : -1;
+
+        total += res;
+
+        if ((size_t)res < iov[i].iov_len)
+            break;
+    }
+
+    return total;
+}
+
+ssize_t _pwrite_r(struct _reent *r, int fd, const void *buf, size_t n, off_t off)
+{
+    struct iovec iov = { .iov_base = (void *)buf, .iov_len = n };
+    return _pwritev_r(r, fd, &iov, 1, off);
+}
+
+ssize_t pwrite(int fd, const void *buf, size_t n, off_t off)
+{
+    return _pwrite_r(_REENT, fd, buf, n, off);
+}
+
+ssize_t _pread_r(struct _reent *r, int fd, void *buf, size_t n, off_t off)
+{
+    struct iovec iov = { .iov_base = buf, .iov_len = n };
+    return _preadv_r(r, fd, &iov, 1, off);
+}
+
+ssize_t pread(int fd, void *buf, size_t n, off_t off)
+{
+    return _pread_r(_REENT, fd, buf, n, off);
+}
+
+ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t off)
+{
+    return _preadv_r(_REENT, fd, iov, iovcnt, off);
+}
+
+ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t off)
+{
+    return _pwritev_r(_REENT, fd, iov, iovcnt, off);
+}
@@ -0,0 +1,357 @@
+#ifndef __SWITCH__
+// memfd_create
+#define _GNU_SOURCE
+#endif
+
+#include "jit_memory.h"
+#include "io_util.h"
+#include "profiler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#else
+// A memfd mapped twice stands in for the switch code memory in native/tests
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Chunks are carved out of the regions in pages, the code manager asks for 64KB or more at a time
+#define JIT_PAGE_SIZE 0x1000
+
+// The kernel limit on code regions is around 10 per process, part of those may be in use by other libraries
+#define MAX_JIT_REGIONS 8
+
+typedef struct
+{
+#ifdef __SWITCH__
+    Jit jit;
+#else
+    int fd;
+#endif
+    unsigned char *rw;
+    unsigned char *rx;
+    size_t size;
+
+    // One bit per page, set when the page is used
+    unsigned char *used;
+    // Size in pages of the chunk that starts at each page, for mono_nx_code_free
+    uint32_t *chunk_pages;
+    size_t page_count;
+    size_t used_pages;
+} jit_region_t;
+
+static pthread_mutex_t jit_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static jit_region_t regions[MAX_JIT_REGIONS];
+static int region_count = 0;
+static int region_limit = 0;
+static size_t region_size = 0;
+
+static struct
+{
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t failed;
+    size_t peak_pages;
+} stats;
+
+static bool page_used(jit_region_t *region, size_t page)
+{
+    return region->used[page / 8] & (1 << (page % 8));
+}
+
+static void mark_pages(jit_region_t *region, size_t first, size_t count, bool used)
+{
+    for (size_t i = first; i < first + count; i++)
+    {
+        if (used)
+            region->used[i / 8] |= (1 << (i % 8));
+        else
+            region->used[i / 8] &= ~(1 << (i % 8));
+    }
+
+    region->used_pages = used ? region->used_pages + count : region->used_pages - count;
+}
+
+static bool map_region(jit_region_t *region, size_t size)
+{
+#ifdef __SWITCH__
+    Result rc = jitCreate(&region->jit, size);
+    if (R_FAILED(rc))
+    {
+        io_debugf("jitCreate failed: %x", rc);
+        return false;
+    }
+
+    // Only the code memory backend keeps both views mapped at the same time, with the others making the region writable
+    // would unmap the RX view while another thread may be running code from it
+    if (region->jit.type != JitType_CodeMemory)
+    {
+        io_debugf("JIT memory needs the code memory backend, got %d", region->jit.type);
+        jitClose(&region->jit);
+        return false;
+    }
+
+    rc = jitTransitionToWritable(&region->jit);
+    if (R_FAILED(rc))
+    {
+        io_debugf("jitTransitionToWritable failed: %x", rc);
+        jitClose(&region->jit);
+        return false;
+    }
+
+    region->rw = jitGetRwAddr(&region->jit);
+    region->rx = jitGetRxAddr(&region->jit);
+#else
+    region->fd = memfd_create("mono_nx_jit", 0);
+    if (region->fd < 0 || ftruncate(region->fd, size) < 0)
+    {
+        io_debugf("memfd for JIT memory failed");
+        if (region->fd >= 0)
+            close(region->fd);
+        return false;
+    }
+
+    region->rw = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, region->fd, 0);
+    region->rx = mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_SHARED, region->fd, 0);
+    if (region->rw == MAP_FAILED || region->rx == MAP_FAILED)
+    {
+        io_debugf("mapping JIT memory failed");
+        if (region->rw != MAP_FAILED)
+            munmap(region->rw, size);
+        if (region->rx != MAP_FAILED)
+            munmap(region->rx, size);
+        close(region->fd);
+        return false;
+    }
+#endif
+
+    region->size = size;
+    return true;
+}
+
+static void unmap_region(jit_region_t *region)
+{
+#ifdef __SWITCH__
+    jitClose(&region->jit);
+#else
+    munmap(region->rw, region->size);
+    munmap(region->rx, region->size);
+    close(region->fd);
+#endif
+}
+
+static jit_region_t *add_region()
+{
+    if (region_count >= region_limit)
+        return NULL;
+
+    jit_region_t *region = &regions[region_count];
+    memset(region, 0, sizeof(*region));
+
+    region->page_count = region_size / JIT_PAGE_SIZE;
+    region->used = calloc((region->page_count + 7) / 8, 1);
+    region->chunk_pages = calloc(region->page_count, sizeof(uint32_t));
+    if (!region->used || !region->chunk_pages || !map_region(region, region_size))
+    {
+        free(region->used);
+        free(region->chunk_pages);
+        return NULL;
+    }
+
+    io_debugf("JIT region %d: rw=%p rx=%p size=%zu KB", region_count, region->rw, region->rx, region_size / 1024);
+
+    // Lookups don't take the lock, the region must be complete before it becomes visible
+    __atomic_store_n(&region_count, region_count + 1, __ATOMIC_RELEASE);
+    return region;
+}
+
+static void jit_memory_report()
+{
+    size_t used_pages = 0;
+    for (int i = 0; i < region_count; i++)
+        used_pages += regions[i].used_pages;
+
+    io_debugf("jit memory: %d/%d regions of %zu KB, %zu KB used, peak %zu KB", region_count, region_limit, region_size / 1024,
+        used_pages * JIT_PAGE_SIZE / 1024, stats.peak_pages * JIT_PAGE_SIZE / 1024);
+    io_debugf("jit memory: %llu allocations, %llu frees, %llu failed",
+        (unsigned long long)stats.allocations, (unsigned long long)stats.frees, (unsigned long long)stats.failed);
+}
+
+bool jit_memory_initialize(size_t size, int max_regions)
+{
+    pthread_mutex_lock(&jit_mutex);
+
+    region_size = (size + JIT_PAGE_SIZE - 1) & ~(size_t)(JIT_PAGE_SIZE - 1);
+    region_limit = max_regions < 1 ? 1 : max_regions > MAX_JIT_REGIONS ? MAX_JIT_REGIONS : max_regions;
+
+    // Reserving the first region now tells the launcher whether JIT can be used at all
+    bool result = region_count > 0 || add_region() != NULL;
+    pthread_mutex_unlock(&jit_mutex);
+
+    if (result)
+        profiler_register_report(jit_memory_report);
+
+    return result;
+}
+
+void jit_memory_dispose()
+{
+    pthread_mutex_lock(&jit_mutex);
+
+    for (int i = 0; i < region_count; i++)
+    {
+        unmap_region(&regions[i]);
+        free(regions[i].used);
+        free(regions[i].chunk_pages);
+    }
+
+    region_count = 0;
+    pthread_mutex_unlock(&jit_mutex);
+}
+
+// First fit search for count free pages
+static bool find_pages(jit_region_t *region, size_t count, size_t *first)
+{
+    size_t run = 0;
+    for (size_t i = 0; i < region->page_count; i++)
+    {
+        run = page_used(region, i) ? 0 : run + 1;
+        if (run == count)
+        {
+            *first = i + 1 - count;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static jit_region_t *region_of_rx(const void *rx)
+{
+    const unsigned char *p = rx;
+    int count = __atomic_load_n(&region_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++)
+        if (p >= regions[i].rx && p < regions[i].rx + regions[i].size)
+            return &regions[i];
+
+    return NULL;
+}
+
+void *mono_nx_code_alloc(size_t size, void **rw)
+{
+    size_t count = (size + JIT_PAGE_SIZE - 1) / JIT_PAGE_SIZE;
+    if (count == 0)
+        return NULL;
+
+    pthread_mutex_lock(&jit_mutex);
+
+    jit_region_t *region = NULL;
+    size_t first = 0;
+
+    for (int i = 0; i < region_count && !region; i++)
+        if (regions[i].page_count - regions[i].used_pages >= count && find_pages(&regions[i], count, &first))
+            region = &regions[i];
+
+    if (!region && count <= region_size / JIT_PAGE_SIZE)
+    {
+        region = add_region();
+        first = 0;
+    }
+
+    if (!region)
+    {
+        stats.failed++;
+        pthread_mutex_unlock(&jit_mutex);
+        io_debugf("Out of JIT memory allocating %zu bytes", size);
+        return NULL;
+    }
+
+    mark_pages(region, first, count, true);
+    region->chunk_pages[first] = (uint32_t)count;
+
+    size_t used_pages = 0;
+    for (int i = 0; i < region_count; i++)
+        used_pages += regions[i].used_pages;
+    if (used_pages > stats.peak_pages)
+        stats.peak_pages = used_pages;
+    stats.allocations++;
+
+    pthread_mutex_unlock(&jit_mutex);
+
+    size_t offset = first * JIT_PAGE_SIZE;
+    if (rw)
+        *rw = region->rw + offset;
+
+    return region->rx + offset;
+}
+
+void mono_nx_code_free(void *rx)
+{
+    if (!rx)
+        return;
+
+    pthread_mutex_lock(&jit_mutex);
+
+    jit_region_t *region = region_of_rx(rx);
+    if (!region)
+    {
+        pthread_mutex_unlock(&jit_mutex);
+        io_debugf("mono_nx_code_free: %p is not JIT memory", rx);
+        return;
+    }
+
+    size_t offset = (unsigned char *)rx - region->rx;
+    size_t first = offset / JIT_PAGE_SIZE;
+    size_t count = region->chunk_pages[first];
+
+    if (offset % JIT_PAGE_SIZE || count == 0)
+    {
+        pthread_mutex_unlock(&jit_mutex);
+        io_debugf("mono_nx_code_free: %p is not the start of a chunk", rx);
+        return;
+    }
+
+    mark_pages(region, first, count, false);
+    region->chunk_pages[first] = 0;
+    stats.frees++;
+
+    pthread_mutex_unlock(&jit_mutex);
+}
+
+// Regions are only added under the lock and never move until jit_memory_dispose, so lookups don't need it
+void *mono_nx_code_rw(void *rx)
+{
+    jit_region_t *region = region_of_rx(rx);
+    return region ? region->rw + ((unsigned char *)rx - region->rx) : NULL;
+}
+
+void *mono_nx_code_rx(void *rw)
+{
+    const unsigned char *p = rw;
+    int count = __atomic_load_n(&region_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++)
+        if (p >= regions[i].rw && p < regions[i].rw + regions[i].size)
+            return regions[i].rx + (p - regions[i].rw);
+
+    return NULL;
+}
+
+void mono_nx_code_flush(void *rx, size_t size)
+{
+#ifdef __SWITCH__
+    void *rw = mono_nx_code_rw(rx);
+    if (!rw)
+        return;
+
+    // Same as jitTransitionToExecutable but limited to the code that was just written
+    armDCacheFlush(rw, size);
+    armICacheInvalidate(rx, size);
+#else
+    __builtin___clear_cache((char *)rx, (char *)rx + size);
+#endif
+}
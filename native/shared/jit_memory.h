@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Executable memory for mono's JIT.
+// Switch memory is W^X and the writable and executable views of JIT memory live at different addresses, so mono's code manager
+// can't just allocate RWX pages. Instead it allocates chunks here, writes code through the RW view and runs it from the RX view.
+// The kernel only allows a handful of code regions per process so a few large regions are reserved up front and chunks are carved out of them.
+// See notes/jit.md for the contract with the code manager in the mono fork.
+
+// Reserves the first region, more are created on demand up to max_regions. Returns false if code memory is not available
+bool jit_memory_initialize(size_t region_size, int max_regions);
+
+// Releases every region, no code from them must be running
+void jit_memory_dispose();
+
+// The following are called by the code manager in the mono fork
+
+// Allocates size bytes of code memory, returns the RX address and stores the RW address of the same memory in rw
+void *mono_nx_code_alloc(size_t size, void **rw);
+
+// Frees a chunk returned by mono_nx_code_alloc, takes the RX address
+void mono_nx_code_free(void *rx);
+
+// Translate an address, or an offset inside a chunk, between the two views. Return NULL for addresses that are not JIT memory
+void *mono_nx_code_rw(void *rx);
+void *mono_nx_code_rx(void *rw);
+
+// Makes code written through the RW view visible to the RX view, must be called before the code runs
+void mono_nx_code_flush(void *rx, size_t size);
@@ -0,0 +1,182 @@
+#include "low_level_monitor.h"
+
+#include <stdlib.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#else
+// pthread stands in for the libnx primitives in native/tests
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#endif
+
+struct LowLevelMonitor
+{
+#ifdef __SWITCH__
+    Mutex mutex;
+    CondVar cond;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+    // Running average of the iterations contended acquires spun, only changed with the mutex held
+    int spins;
+};
+
+static bool enabled;
+static int max_spin;
+
+static inline void cpu_relax()
+{
+#if defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#elif defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#endif
+}
+
+static inline bool mutex_try(LowLevelMonitor *monitor)
+{
+#ifdef __SWITCH__
+    // The libnx mutex holds the owner handle, reading it first keeps the spinning cores from stealing the cache line from the owner
+    return __atomic_load_n(&monitor->mutex, __ATOMIC_RELAXED) == INVALID_HANDLE && mutexTryLock(&monitor->mutex);
+#else
+    return pthread_mutex_trylock(&monitor->mutex) == 0;
+#endif
+}
+
+static inline void mutex_lock(LowLevelMonitor *monitor)
+{
+#ifdef __SWITCH__
+    mutexLock(&monitor->mutex);
+#else
+    pthread_mutex_lock(&monitor->mutex);
+#endif
+}
+
+void low_level_monitor_initialize(bool enable, int spin)
+{
+    enabled = enable;
+    max_spin = spin > 0 ? spin : 0;
+}
+
+bool low_level_monitor_enabled()
+{
+    return enabled;
+}
+
+LowLevelMonitor *low_level_monitor_create()
+{
+    LowLevelMonitor *monitor = calloc(1, sizeof(LowLevelMonitor));
+    if (!monitor)
+        return NULL;
+
+#ifdef __SWITCH__
+    mutexInit(&monitor->mutex);
+    condvarInit(&monitor->cond);
+#else
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&monitor->mutex, NULL);
+    pthread_cond_init(&monitor->cond, &attr);
+    pthread_condattr_destroy(&attr);
+#endif
+
+    return monitor;
+}
+
+void low_level_monitor_destroy(LowLevelMonitor *monitor)
+{
+#ifndef __SWITCH__
+    pthread_mutex_destroy(&monitor->mutex);
+    pthread_cond_destroy(&monitor->cond);
+#endif
+    free(monitor);
+}
+
+// Called with the mutex held, readers outside of it only use the value as a hint
+static inline void update_spins(LowLevelMonitor *monitor, int count)
+{
+    int spins = __atomic_load_n(&monitor->spins, __ATOMIC_RELAXED);
+    __atomic_store_n(&monitor->spins, spins + (count - spins) / 8, __ATOMIC_RELAXED);
+}
+
+void low_level_monitor_acquire(LowLevelMonitor *monitor)
+{
+    if (mutex_try(monitor))
+        return;
+
+    if (max_spin)
+    {
+        // Allow a bit more than the average so the estimate can grow
+        int limit = __atomic_load_n(&monitor->spins, __ATOMIC_RELAXED) * 2 + 10;
+        if (limit > max_spin)
+            limit = max_spin;
+
+        for (int count = 1; count <= limit; count++)
+        {
+            cpu_relax();
+            if (mutex_try(monitor))
+            {
+                update_spins(monitor, count);
+                return;
+            }
+        }
+
+        mutex_lock(monitor);
+        update_spins(monitor, limit);
+        return;
+    }
+
+    mutex_lock(monitor);
+}
+
+void low_level_monitor_release(LowLevelMonitor *monitor)
+{
+#ifdef __SWITCH__
+    mutexUnlock(&monitor->mutex);
+#else
+    pthread_mutex_unlock(&monitor->mutex);
+#endif
+}
+
+void low_level_monitor_wait(LowLevelMonitor *monitor)
+{
+#ifdef __SWITCH__
+    condvarWait(&monitor->cond, &monitor->mutex);
+#else
+    pthread_cond_wait(&monitor->cond, &monitor->mutex);
+#endif
+}
+
+int32_t low_level_monitor_timed_wait(LowLevelMonitor *monitor, int32_t timeout_ms)
+{
+#ifdef __SWITCH__
+    Result rc = condvarWaitTimeout(&monitor->cond, &monitor->mutex, (uint64_t)timeout_ms * 1000000);
+    return R_SUCCEEDED(rc);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(&monitor->cond, &monitor->mutex, &ts) != ETIMEDOUT;
+#endif
+}
+
+void low_level_monitor_signal_release(LowLevelMonitor *monitor)
+{
+#ifdef __SWITCH__
+    condvarWakeOne(&monitor->cond);
+    mutexUnlock(&monitor->mutex);
+#else
+    pthread_cond_signal(&monitor->cond);
+    pthread_mutex_unlock(&monitor->mutex);
+#endif
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Replacement for the SystemNative_LowLevelMonitor_* functions, the mutex and condition variable behind LowLevelLock and the thread pool.
+// The PAL uses pthread which newlib implements on top of the libnx primitives, this uses libnx Mutex and CondVar directly.
+// A contended acquire spins for a while before blocking in the kernel, the holder is often running on another core and about to release.
+// How long to spin adapts per monitor to how long past acquires had to spin, like glibc's adaptive mutexes. See notes/threads.md
+
+typedef struct LowLevelMonitor LowLevelMonitor;
+
+// Called before the runtime starts. max_spin bounds the spin iterations of an acquire, 0 always blocks
+void low_level_monitor_initialize(bool enabled, int max_spin);
+
+// When false the dlshim keeps the PAL functions
+bool low_level_monitor_enabled();
+
+// Same signatures and semantics as the PAL functions, waits can wake up spuriously
+LowLevelMonitor *low_level_monitor_create();
+void low_level_monitor_destroy(LowLevelMonitor *monitor);
+void low_level_monitor_acquire(LowLevelMonitor *monitor);
+void low_level_monitor_release(LowLevelMonitor *monitor);
+void low_level_monitor_wait(LowLevelMonitor *monitor);
+// Returns 0 if the timeout expired
+int32_t low_level_monitor_timed_wait(LowLevelMonitor *monitor, int32_t timeout_ms);
+void low_level_monitor_signal_release(LowLevelMonitor *monitor);
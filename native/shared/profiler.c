@@ -0,0 +1,74 @@
+#include "profiler.h"
+#include "io_util.h"
+
+#include <switch.h>
+
+#define MAX_MARKS 32
+#define MAX_CALLBACKS 8
+
+struct ProfilerMark
+{
+    const char *name;
+    u64 tick;
+};
+
+static bool profiler_active = false;
+static u64 start_tick;
+
+static struct ProfilerMark marks[MAX_MARKS];
+static int mark_count = 0;
+
+static profiler_report_callback callbacks[MAX_CALLBACKS];
+static int callback_count = 0;
+
+void profiler_init(bool enabled)
+{
+    profiler_active = enabled;
+    start_tick = armGetSystemTick();
+    mark_count = 0;
+}
+
+bool profiler_enabled()
+{
+    return profiler_active;
+}
+
+void profiler_mark(const char *name)
+{
+    if (!profiler_active || mark_count >= MAX_MARKS)
+        return;
+
+    marks[mark_count].name = name;
+    marks[mark_count].tick = armGetSystemTick();
+    mark_count++;
+}
+
+void profiler_register_report(profiler_report_callback callback)
+{
+    if (callback_count >= MAX_CALLBACKS)
+        return;
+
+    callbacks[callback_count++] = callback;
+}
+
+void profiler_report()
+{
+    if (!profiler_active)
+        return;
+
+    io_debugf("--- startup profile ---");
+
+    u64 last = start_tick;
+    for (int i = 0; i < mark_count; i++)
+    {
+        unsigned long long total_us = armTicksToNs(marks[i].tick - start_tick) / 1000;
+        unsigned long long delta_us = armTicksToNs(marks[i].tick - last) / 1000;
+        io_debugf("%-32s %8llu us (+%llu us)", marks[i].name, total_us, delta_us);
+        last = marks[i].tick;
+    }
+
+    for (int i = 0; i < callback_count; i++)
+        callbacks[i]();
+
+    io_debugf("-----------------------");
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Minimal startup profiler, enabled with startup_profile in config.ini.
+// Marks are timestamps relative to profiler_init, subsystems can register a callback to print their own counters in the report.
+
+typedef void (*profiler_report_callback)(void);
+
+void profiler_init(bool enabled);
+
+bool profiler_enabled();
+
+void profiler_mark(const char *name);
+
+void profiler_register_report(profiler_report_callback callback);
+
+// Prints all marks and registered counters, this is a no-op when the profiler is disabled
+void profiler_report();
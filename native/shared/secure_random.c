@@ -0,0 +1,220 @@
+#include "secure_random.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#else
+// getentropy stands in for csrng in native/tests
+#include <unistd.h>
+#endif
+
+#define KEY_SIZE 32
+#define BLOCK_SIZE 64
+
+// Output generated per refill, the first KEY_SIZE bytes become the next key
+#define BUFFER_SIZE (16 * BLOCK_SIZE)
+
+#define RESEED_BYTES (1024 * 1024)
+
+// Seeds fetched from csrng with a single request
+#define SEED_BATCH (32 * KEY_SIZE)
+
+struct generator
+{
+    uint32_t key[KEY_SIZE / 4];
+    uint8_t buffer[BUFFER_SIZE];
+    // Unused bytes are at the end of the buffer
+    size_t available;
+    size_t since_reseed;
+    bool seeded;
+};
+
+static bool enabled;
+
+static pthread_mutex_t seed_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t seed_pool[SEED_BATCH];
+static size_t seed_available;
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t generator_key;
+static __thread struct generator *thread_generator;
+
+static void wipe(void *data, size_t length)
+{
+    volatile uint8_t *p = data;
+    while (length--)
+        *p++ = 0;
+}
+
+static int entropy_bytes(uint8_t *buffer, size_t length)
+{
+#ifdef __SWITCH__
+    return R_SUCCEEDED(csrngGetRandomBytes(buffer, length)) ? 0 : -1;
+#else
+    // getentropy is limited to 256 bytes per call
+    for (size_t done = 0; done < length; done += 256)
+        if (getentropy(buffer + done, length - done < 256 ? length - done : 256))
+            return -1;
+    return 0;
+#endif
+}
+
+static int take_seed(uint8_t seed[KEY_SIZE])
+{
+    pthread_mutex_lock(&seed_mutex);
+
+    if (seed_available < KEY_SIZE)
+    {
+        if (entropy_bytes(seed_pool, SEED_BATCH))
+        {
+            pthread_mutex_unlock(&seed_mutex);
+            return -1;
+        }
+        seed_available = SEED_BATCH;
+    }
+
+    seed_available -= KEY_SIZE;
+    memcpy(seed, seed_pool + seed_available, KEY_SIZE);
+    wipe(seed_pool + seed_available, KEY_SIZE);
+
+    pthread_mutex_unlock(&seed_mutex);
+    return 0;
+}
+
+#define ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER_ROUND(a, b, c, d) \
+    a += b; d ^= a; d = ROTL(d, 16); \
+    c += d; b ^= c; b = ROTL(b, 12); \
+    a += b; d ^= a; d = ROTL(d, 8); \
+    c += d; b ^= c; b = ROTL(b, 7);
+
+// One ChaCha20 block with a 64 bit block counter and a zero nonce, every key is only used for one buffer.
+// Little endian output, both the switch and the linux hosts we test on are little endian
+static void chacha20_block(const uint32_t key[8], uint64_t counter, uint8_t out[BLOCK_SIZE])
+{
+    uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        (uint32_t)counter, (uint32_t)(counter >> 32), 0, 0
+    };
+
+    uint32_t x[16];
+    memcpy(x, input, sizeof(x));
+
+    for (int i = 0; i < 10; i++)
+    {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; i++)
+        x[i] += input[i];
+
+    memcpy(out, x, BLOCK_SIZE);
+    wipe(x, sizeof(x));
+}
+
+static int refill(struct generator *g)
+{
+    if (!g->seeded || g->since_reseed >= RESEED_BYTES)
+    {
+        // The seed is mixed into the current key rather than replacing it
+        uint8_t seed[KEY_SIZE];
+        if (take_seed(seed))
+            return -1;
+
+        for (int i = 0; i < KEY_SIZE / 4; i++)
+        {
+            uint32_t word;
+            memcpy(&word, seed + i * 4, 4);
+            g->key[i] ^= word;
+        }
+
+        wipe(seed, sizeof(seed));
+        g->seeded = true;
+        g->since_reseed = 0;
+    }
+
+    for (int i = 0; i < BUFFER_SIZE / BLOCK_SIZE; i++)
+        chacha20_block(g->key, i, g->buffer + i * BLOCK_SIZE);
+
+    memcpy(g->key, g->buffer, KEY_SIZE);
+    wipe(g->buffer, KEY_SIZE);
+
+    g->available = BUFFER_SIZE - KEY_SIZE;
+    g->since_reseed += BUFFER_SIZE;
+    return 0;
+}
+
+static void generator_destroy(void *param)
+{
+    wipe(param, sizeof(struct generator));
+    free(param);
+}
+
+static void key_create()
+{
+    pthread_key_create(&generator_key, generator_destroy);
+}
+
+// The state is allocated on first use so threads that never ask for random bytes don't pay for it in their TLS
+static struct generator *generator_get()
+{
+    if (thread_generator)
+        return thread_generator;
+
+    pthread_once(&key_once, key_create);
+
+    struct generator *g = calloc(1, sizeof(struct generator));
+    if (!g)
+        return NULL;
+
+    pthread_setspecific(generator_key, g);
+    thread_generator = g;
+    return g;
+}
+
+void secure_random_initialize(bool enable)
+{
+    enabled = enable;
+}
+
+int secure_random_bytes(void *buffer, size_t length)
+{
+    if (!enabled)
+        return -1;
+
+    struct generator *g = generator_get();
+    if (!g)
+        return -1;
+
+    uint8_t *out = buffer;
+    while (length)
+    {
+        if (!g->available && refill(g))
+            return -1;
+
+        size_t chunk = length < g->available ? length : g->available;
+        uint8_t *source = g->buffer + BUFFER_SIZE - g->available;
+
+        memcpy(out, source, chunk);
+        wipe(source, chunk);
+
+        g->available -= chunk;
+        out += chunk;
+        length -= chunk;
+    }
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Random bytes for SystemNative_GetCryptographicallySecureRandomBytes and GetNonCryptographicallySecureRandomBytes.
+// The PAL asks the csrng service for every request, even the 16 bytes of a Guid.NewGuid().
+// Instead each thread runs its own ChaCha20 generator seeded from csrng. Seeds are fetched in batches so one IPC covers many threads and reseeds.
+// Every refill replaces the key with part of its own output (fast key erasure) and bytes are wiped from the buffer once handed out,
+// so the state of a thread doesn't reveal what it generated before. Each thread also reseeds from csrng after 1 MB of output.
+
+// Called after csrngInitialize, the generator is unused when disabled
+void secure_random_initialize(bool enabled);
+
+// Returns 0 on success, -1 when disabled or when csrng can't provide a seed, the caller should fall back to the PAL
+int secure_random_bytes(void *buffer, size_t length);
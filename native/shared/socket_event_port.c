@@ -0,0 +1,385 @@
+#include "socket_event_port.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+struct fd_entry
+{
+    // NULL when the fd is not registered
+    struct socket_event_port *port;
+    // Position in port->fds
+    int index;
+    int32_t events;
+    // Registered events that can still be reported, cleared when reported and set again by socket_event_port_rearm
+    int32_t armed;
+    uintptr_t data;
+};
+
+struct socket_event_port
+{
+    // UDP socket connected to itself, there are no pipes or eventfds that poll accepts on switch
+    int wake_fd;
+    bool polling;
+    bool woken;
+
+    int *fds;
+    int count;
+    int capacity;
+
+    // Only used by the waiting thread
+    struct pollfd *pollfds;
+    int pollfds_capacity;
+};
+
+// All the ports share the fd table, there is one per SocketAsyncEngine and sockets don't say which one they belong to when rearmed
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct fd_entry *entries;
+static int entries_capacity;
+
+// Set by the first socket_event_port_create. Until then nothing can be registered, rearm and forget run on every
+// blocked socket call and every close so they return without the lock
+static bool ports_created;
+
+static struct fd_entry *entry_locked(int fd)
+{
+    if (fd < 0 || fd >= entries_capacity)
+        return NULL;
+    return &entries[fd];
+}
+
+static bool grow_locked(void **array, int *capacity, int required, size_t element)
+{
+    if (required <= *capacity)
+        return true;
+
+    int size = *capacity ? *capacity : 64;
+    while (size < required)
+        size *= 2;
+
+    void *grown = realloc(*array, size * element);
+    if (!grown)
+        return false;
+
+    memset((char *)grown + *capacity * element, 0, (size - *capacity) * element);
+    *array = grown;
+    *capacity = size;
+    return true;
+}
+
+static void wake_locked(struct socket_event_port *port)
+{
+    if (!port->polling || port->woken)
+        return;
+
+    port->woken = true;
+    char byte = 0;
+    send(port->wake_fd, &byte, 1, 0);
+}
+
+static void remove_locked(int fd)
+{
+    struct fd_entry *entry = entry_locked(fd);
+    if (!entry || !entry->port)
+        return;
+
+    struct socket_event_port *port = entry->port;
+    int last = port->fds[--port->count];
+    port->fds[entry->index] = last;
+    entries[last].index = entry->index;
+
+    entry->port = NULL;
+}
+
+static int create_wake_socket()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return -1;
+
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+        getsockname(fd, (struct sockaddr *)&addr, &length) ||
+        connect(fd, (struct sockaddr *)&addr, length) ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK))
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+
+    return fd;
+}
+
+int socket_event_port_create(struct socket_event_port **port)
+{
+    struct socket_event_port *result = calloc(1, sizeof(struct socket_event_port));
+    if (!result)
+        return ENOMEM;
+
+    result->wake_fd = create_wake_socket();
+    if (result->wake_fd < 0)
+    {
+        int error = errno;
+        free(result);
+        return error;
+    }
+
+    __atomic_store_n(&ports_created, true, __ATOMIC_RELEASE);
+
+    *port = result;
+    return 0;
+}
+
+void socket_event_port_close(struct socket_event_port *port)
+{
+    pthread_mutex_lock(&mutex);
+    for (int i = 0; i < port->count; i++)
+        entries[port->fds[i]].port = NULL;
+    pthread_mutex_unlock(&mutex);
+
+    close(port->wake_fd);
+    free(port->fds);
+    free(port->pollfds);
+    free(port);
+}
+
+int socket_event_port_change(struct socket_event_port *port, int fd, int32_t events, uintptr_t data)
+{
+    if (fd < 0)
+        return EBADF;
+
+    pthread_mutex_lock(&mutex);
+
+    if (!events)
+    {
+        struct fd_entry *entry = entry_locked(fd);
+        if (entry && entry->port == port)
+            remove_locked(fd);
+
+        pthread_mutex_unlock(&mutex);
+        return 0;
+    }
+
+    if (!grow_locked((void **)&entries, &entries_capacity, fd + 1, sizeof(struct fd_entry)))
+    {
+        pthread_mutex_unlock(&mutex);
+        return ENOMEM;
+    }
+
+    struct fd_entry *entry = &entries[fd];
+    if (entry->port && entry->port != port)
+        remove_locked(fd);
+
+    if (!entry->port)
+    {
+        if (!grow_locked((void **)&port->fds, &port->capacity, port->count + 1, sizeof(int)))
+        {
+            pthread_mutex_unlock(&mutex);
+            return ENOMEM;
+        }
+
+        entry->port = port;
+        entry->index = port->count;
+        port->fds[port->count++] = fd;
+    }
+
+    entry->events = events;
+    entry->armed = events;
+    entry->data = data;
+
+    // The waiting thread has to rebuild its poll set
+    wake_locked(port);
+
+    pthread_mutex_unlock(&mutex);
+    return 0;
+}
+
+void socket_event_port_rearm(int fd, int32_t events)
+{
+    if (!__atomic_load_n(&ports_created, __ATOMIC_ACQUIRE))
+        return;
+
+    pthread_mutex_lock(&mutex);
+
+    struct fd_entry *entry = entry_locked(fd);
+    if (entry && entry->port && (entry->armed & events) != (entry->events & events))
+    {
+        entry->armed |= entry->events & events;
+        wake_locked(entry->port);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+void socket_event_port_forget(int fd)
+{
+    if (!__atomic_load_n(&ports_created, __ATOMIC_ACQUIRE))
+        return;
+
+    pthread_mutex_lock(&mutex);
+
+    // A poll in progress can keep the socket alive after close, get it out of the set
+    struct fd_entry *entry = entry_locked(fd);
+    if (entry && entry->port)
+    {
+        struct socket_event_port *port = entry->port;
+        remove_locked(fd);
+        wake_locked(port);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+// Fills pollfds with the armed sockets, the wake socket goes first. Returns the number of entries or -1
+static int build_poll_set_locked(struct socket_event_port *port)
+{
+    if (!grow_locked((void **)&port->pollfds, &port->pollfds_capacity, port->count + 1, sizeof(struct pollfd)))
+        return -1;
+
+    port->pollfds[0].fd = port->wake_fd;
+    port->pollfds[0].events = POLLIN;
+    port->pollfds[0].revents = 0;
+
+    int count = 1;
+    for (int i = 0; i < port->count; i++)
+    {
+        int fd = port->fds[i];
+        int32_t armed = entries[fd].events & entries[fd].armed;
+
+        short events = 0;
+        if (armed & SOCKET_EVENT_READ)
+            events |= POLLIN;
+        if (armed & SOCKET_EVENT_WRITE)
+            events |= POLLOUT;
+
+        // Errors and hangups are reported even if not asked for, so sockets with nothing armed are left out entirely
+        if (!events)
+            continue;
+
+        port->pollfds[count].fd = fd;
+        port->pollfds[count].events = events;
+        port->pollfds[count].revents = 0;
+        count++;
+    }
+
+    return count;
+}
+
+// A socket in the set was closed without being unregistered, libnx fails the whole poll for that so find and drop it
+static void drop_invalid_locked(struct socket_event_port *port, int count)
+{
+    for (int i = 1; i < count; i++)
+    {
+        struct pollfd single = { .fd = port->pollfds[i].fd, .events = 0 };
+        if ((poll(&single, 1, 0) < 0 && errno == EBADF) || (single.revents & POLLNVAL))
+            remove_locked(single.fd);
+    }
+}
+
+static void drain_wake_socket(struct socket_event_port *port)
+{
+    char buffer[16];
+    while (recv(port->wake_fd, buffer, sizeof(buffer), 0) > 0);
+}
+
+static int32_t translate_events(short revents)
+{
+    int32_t events = 0;
+    if (revents & (POLLIN | POLLPRI))
+        events |= SOCKET_EVENT_READ;
+    if (revents & POLLOUT)
+        events |= SOCKET_EVENT_WRITE;
+    if (revents & POLLHUP)
+        events |= SOCKET_EVENT_CLOSE;
+    if (revents & POLLERR)
+        events |= SOCKET_EVENT_ERROR;
+    return events;
+}
+
+int socket_event_port_wait(struct socket_event_port *port, struct socket_event *buffer, int32_t *count)
+{
+    int32_t capacity = *count;
+    int32_t found = 0;
+
+    while (!found)
+    {
+        pthread_mutex_lock(&mutex);
+        int poll_count = build_poll_set_locked(port);
+        port->polling = poll_count > 0;
+        pthread_mutex_unlock(&mutex);
+
+        if (poll_count < 0)
+            return ENOMEM;
+
+        int res = poll(port->pollfds, poll_count, -1);
+        int error = errno;
+
+        pthread_mutex_lock(&mutex);
+        port->polling = false;
+
+        if (res < 0)
+        {
+            if (error == EBADF)
+                drop_invalid_locked(port, poll_count);
+
+            pthread_mutex_unlock(&mutex);
+
+            if (error == EINTR || error == EBADF)
+                continue;
+            return error;
+        }
+
+        // Nobody sends while we're not polling, after the drain the next poll starts clean
+        if (port->woken || port->pollfds[0].revents)
+            drain_wake_socket(port);
+        port->woken = false;
+
+        for (int i = 1; i < poll_count && found < capacity; i++)
+        {
+            struct pollfd *pfd = &port->pollfds[i];
+            if (!pfd->revents)
+                continue;
+
+            // Unregistered or moved to another port while we were polling
+            struct fd_entry *entry = entry_locked(pfd->fd);
+            if (!entry || entry->port != port)
+                continue;
+
+            if (pfd->revents & POLLNVAL)
+            {
+                remove_locked(pfd->fd);
+                continue;
+            }
+
+            int32_t events = translate_events(pfd->revents);
+            if (events & (SOCKET_EVENT_CLOSE | SOCKET_EVENT_ERROR))
+                entry->armed = 0;
+            else
+                entry->armed &= ~events;
+
+            buffer[found].data = entry->data;
+            buffer[found].events = events;
+            buffer[found].padding = 0;
+            found++;
+        }
+
+        pthread_mutex_unlock(&mutex);
+    }
+
+    *count = found;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// SocketEventPort of System.Native implemented with poll, the PAL only has epoll and kqueue backends and returns ENOSYS without them.
+// The runtime's SocketAsyncEngine expects edge triggered events, poll is level triggered so an event is reported once and then
+// masked until an operation on that socket fails with EAGAIN, see socket_event_port_rearm. The dlshim hooks do that for the PAL functions.
+// Only depends on poll and sockets so it can be tested on linux against loopback sockets.
+
+// Same values as SocketEvents in pal_networking.h
+#define SOCKET_EVENT_READ 0x01
+#define SOCKET_EVENT_WRITE 0x02
+#define SOCKET_EVENT_READCLOSE 0x04
+#define SOCKET_EVENT_CLOSE 0x08
+#define SOCKET_EVENT_ERROR 0x10
+
+// Same layout as SocketEvent in pal_networking.h
+struct socket_event
+{
+    uintptr_t data;
+    int32_t events;
+    int32_t padding;
+};
+
+struct socket_event_port;
+
+// Functions return 0 or an errno value
+
+int socket_event_port_create(struct socket_event_port **port);
+
+// The sockets still registered are forgotten, they are not closed
+void socket_event_port_close(struct socket_event_port *port);
+
+// Registers, changes or with events 0 removes a socket. A socket can only be registered with one port, registering it again moves it.
+// The current state of the socket is reported again after each change, like epoll does.
+int socket_event_port_change(struct socket_event_port *port, int fd, int32_t events, uintptr_t data);
+
+// Blocks until at least one event is ready. count is the size of buffer on input and the number of events written on output.
+// Only one thread can wait on a port at a time.
+int socket_event_port_wait(struct socket_event_port *port, struct socket_event *buffer, int32_t *count);
+
+// An operation on fd would block, events on the socket can be reported again. Free until a port is created
+void socket_event_port_rearm(int fd, int32_t events);
+
+// fd is about to be closed, drops its registration so the number can be reused. Free until a port is created
+void socket_event_port_forget(int fd);
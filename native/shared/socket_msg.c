@@ -0,0 +1,206 @@
+// sendmsg and recvmsg for System.Native's SystemNative_SendMessage and SystemNative_ReceiveMessage.
+// The launchers are linked with --wrap for sendmsg, recvmsg, socket and accept so the PAL calls end up here.
+// Messages are sent and received with sendto and recvfrom, which every bsd implementation supports including the emulators.
+// A single buffer is used in place, multiple buffers are gathered into or scattered from a pooled staging buffer.
+// Messages with control data are passed to the real functions since they can't be expressed with sendto and recvfrom.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+// Larger than any UDP datagram, so a datagram that doesn't fit the caller's buffers is detected as truncated
+#define STAGING_SIZE (64 * 1024)
+
+// Socket types by fd, recorded when sockets are created so datagram truncation can be detected without asking the service every time
+#define MAX_TRACKED_FDS 1024
+
+static uint8_t socket_types[MAX_TRACKED_FDS];
+
+// Staging buffers cached for reuse, more can be in use at once but the extra ones are freed when released
+#define POOLED_BUFFERS 8
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void *pool[POOLED_BUFFERS];
+static int pool_count;
+
+ssize_t __real_sendmsg(int sockfd, const struct msghdr *msg, int flags);
+ssize_t __real_recvmsg(int sockfd, struct msghdr *msg, int flags);
+int __real_socket(int domain, int type, int protocol);
+int __real_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
+
+static void *staging_acquire()
+{
+    void *buffer = NULL;
+
+    pthread_mutex_lock(&pool_mutex);
+    if (pool_count)
+        buffer = pool[--pool_count];
+    pthread_mutex_unlock(&pool_mutex);
+
+    return buffer ? buffer : malloc(STAGING_SIZE);
+}
+
+static void staging_release(void *buffer)
+{
+    pthread_mutex_lock(&pool_mutex);
+    if (pool_count < POOLED_BUFFERS)
+    {
+        pool[pool_count++] = buffer;
+        buffer = NULL;
+    }
+    pthread_mutex_unlock(&pool_mutex);
+
+    free(buffer);
+}
+
+static void record_type(int fd, int type)
+{
+    if (fd >= 0 && fd < MAX_TRACKED_FDS)
+        __atomic_store_n(&socket_types[fd], (uint8_t)type, __ATOMIC_RELAXED);
+}
+
+static bool is_stream(int fd)
+{
+    int type = fd >= 0 && fd < MAX_TRACKED_FDS ? __atomic_load_n(&socket_types[fd], __ATOMIC_RELAXED) : 0;
+
+    if (!type)
+    {
+        socklen_t length = sizeof(type);
+        if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length))
+            return true;
+        record_type(fd, type);
+    }
+
+    return type == SOCK_STREAM;
+}
+
+int __wrap_socket(int domain, int type, int protocol)
+{
+    int fd = __real_socket(domain, type, protocol);
+    // Strip flags like SOCK_NONBLOCK that some platforms accept in type
+    record_type(fd, type & 0xF);
+    return fd;
+}
+
+int __wrap_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    int fd = __real_accept(sockfd, addr, addrlen);
+    record_type(fd, SOCK_STREAM);
+    return fd;
+}
+
+static size_t total_length(const struct msghdr *msg)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < (size_t)msg->msg_iovlen; i++)
+        total += msg->msg_iov[i].iov_len;
+    return total;
+}
+
+ssize_t __wrap_sendmsg(int sockfd, const struct msghdr *msg, int flags)
+{
+    if (msg->msg_controllen)
+        return __real_sendmsg(sockfd, msg, flags);
+
+    if (msg->msg_iovlen <= 1)
+    {
+        void *data = msg->msg_iovlen ? msg->msg_iov[0].iov_base : NULL;
+        size_t length = msg->msg_iovlen ? msg->msg_iov[0].iov_len : 0;
+        return sendto(sockfd, data, length, flags, msg->msg_name, msg->msg_namelen);
+    }
+
+    size_t total = total_length(msg);
+    if (total > STAGING_SIZE)
+    {
+        // Datagrams can't be split, stream sockets get a partial send and the caller sends the rest
+        if (!is_stream(sockfd))
+        {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        total = STAGING_SIZE;
+    }
+
+    unsigned char *staging = staging_acquire();
+    if (!staging)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < (size_t)msg->msg_iovlen && offset < total; i++)
+    {
+        size_t chunk = msg->msg_iov[i].iov_len < total - offset ? msg->msg_iov[i].iov_len : total - offset;
+        memcpy(staging + offset, msg->msg_iov[i].iov_base, chunk);
+        offset += chunk;
+    }
+
+    ssize_t res = sendto(sockfd, staging, total, flags, msg->msg_name, msg->msg_namelen);
+
+    int error = errno;
+    staging_release(staging);
+    errno = error;
+
+    return res;
+}
+
+ssize_t __wrap_recvmsg(int sockfd, struct msghdr *msg, int flags)
+{
+    if (msg->msg_controllen)
+        return __real_recvmsg(sockfd, msg, flags);
+
+    size_t total = total_length(msg);
+    socklen_t *name_length = msg->msg_name ? &msg->msg_namelen : NULL;
+
+    msg->msg_flags = 0;
+
+    // Stream sockets never truncate, a single buffer is received in place.
+    // Datagrams go through the staging buffer when they could be larger than the caller's buffer, so truncation can be reported.
+    bool stream = is_stream(sockfd);
+    if (msg->msg_iovlen == 1 && (stream || total >= STAGING_SIZE))
+        return recvfrom(sockfd, msg->msg_iov[0].iov_base, total, flags, msg->msg_name, name_length);
+
+    unsigned char *staging = staging_acquire();
+    if (!staging)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // Asking a stream socket for more than fits would drop the extra bytes
+    size_t request = stream && total < STAGING_SIZE ? total : STAGING_SIZE;
+    ssize_t res = recvfrom(sockfd, staging, request, flags, msg->msg_name, name_length);
+    int error = errno;
+
+    if (res > 0)
+    {
+        size_t received = (size_t)res;
+        if (received > total)
+        {
+            msg->msg_flags |= MSG_TRUNC;
+            received = total;
+        }
+
+        size_t offset = 0;
+        for (size_t i = 0; i < (size_t)msg->msg_iovlen && offset < received; i++)
+        {
+            size_t chunk = msg->msg_iov[i].iov_len < received - offset ? msg->msg_iov[i].iov_len : received - offset;
+            memcpy(msg->msg_iov[i].iov_base, staging + offset, chunk);
+            offset += chunk;
+        }
+
+        // recvmsg returns the copied length unless MSG_TRUNC was passed in flags, then it's the real datagram size
+        if (!(flags & MSG_TRUNC))
+            res = (ssize_t)received;
+    }
+
+    staging_release(staging);
+    errno = error;
+
+    return res;
+}
@@ -0,0 +1,284 @@
+#include "socket_sendfile.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// Large enough that sd card reads and socket sends are both efficient, each pipeline owns two
+#define BUFFER_SIZE (256 * 1024)
+
+// Concurrent transfers beyond this use a temporary buffer without pipelining
+#define MAX_PIPELINES 2
+
+struct pipeline
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    unsigned char *buffers[2];
+    bool busy;
+
+    // Read request for the reader thread
+    bool pending;
+    bool done;
+    int fd;
+    int64_t offset;
+    size_t length;
+    int buffer;
+    ssize_t result;
+    int error;
+};
+
+static pthread_mutex_t pipelines_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct pipeline *pipelines[MAX_PIPELINES];
+static int pipeline_count;
+
+// Buffer of the last direct transfer, kept for the next one. Concurrent direct transfers allocate their own
+static unsigned char *cached_buffer;
+
+static void *reader_thread(void *param)
+{
+    struct pipeline *p = param;
+
+    pthread_mutex_lock(&p->mutex);
+    for (;;)
+    {
+        while (!p->pending)
+            pthread_cond_wait(&p->cond, &p->mutex);
+
+        int fd = p->fd;
+        int64_t offset = p->offset;
+        size_t length = p->length;
+        unsigned char *buffer = p->buffers[p->buffer];
+        pthread_mutex_unlock(&p->mutex);
+
+        ssize_t res;
+        while ((res = pread(fd, buffer, length, (off_t)offset)) < 0 && errno == EINTR);
+        int error = errno;
+
+        pthread_mutex_lock(&p->mutex);
+        p->result = res;
+        p->error = error;
+        p->pending = false;
+        p->done = true;
+        pthread_cond_broadcast(&p->cond);
+    }
+
+    return NULL;
+}
+
+static struct pipeline *pipeline_create()
+{
+    struct pipeline *p = calloc(1, sizeof(struct pipeline));
+    if (!p)
+        return NULL;
+
+    p->buffers[0] = malloc(BUFFER_SIZE);
+    p->buffers[1] = malloc(BUFFER_SIZE);
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->cond, NULL);
+
+    if (!p->buffers[0] || !p->buffers[1] || pthread_create(&p->thread, NULL, reader_thread, p))
+    {
+        free(p->buffers[0]);
+        free(p->buffers[1]);
+        pthread_mutex_destroy(&p->mutex);
+        pthread_cond_destroy(&p->cond);
+        free(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+// Pipelines are created on demand and kept with their reader thread for the lifetime of the process
+static struct pipeline *pipeline_acquire()
+{
+    struct pipeline *result = NULL;
+
+    pthread_mutex_lock(&pipelines_mutex);
+
+    for (int i = 0; i < pipeline_count && !result; i++)
+        if (!pipelines[i]->busy)
+            result = pipelines[i];
+
+    if (!result && pipeline_count < MAX_PIPELINES && (result = pipeline_create()))
+        pipelines[pipeline_count++] = result;
+
+    if (result)
+        result->busy = true;
+
+    pthread_mutex_unlock(&pipelines_mutex);
+    return result;
+}
+
+static void pipeline_release(struct pipeline *p)
+{
+    pthread_mutex_lock(&pipelines_mutex);
+    p->busy = false;
+    pthread_mutex_unlock(&pipelines_mutex);
+}
+
+static void read_start(struct pipeline *p, int buffer, int fd, int64_t offset, size_t length)
+{
+    pthread_mutex_lock(&p->mutex);
+    p->buffer = buffer;
+    p->fd = fd;
+    p->offset = offset;
+    p->length = length;
+    p->done = false;
+    p->pending = true;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+static ssize_t read_finish(struct pipeline *p, int *error)
+{
+    pthread_mutex_lock(&p->mutex);
+    while (!p->done)
+        pthread_cond_wait(&p->cond, &p->mutex);
+    ssize_t res = p->result;
+    *error = p->error;
+    pthread_mutex_unlock(&p->mutex);
+    return res;
+}
+
+// Sends the whole buffer unless the socket would block or fails, returns how much was sent
+static size_t send_all(int fd, const unsigned char *data, size_t length, int *error)
+{
+    size_t sent = 0;
+    while (sent < length)
+    {
+        ssize_t res = send(fd, data + sent, length - sent, 0);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            *error = errno;
+            break;
+        }
+        sent += res;
+    }
+    return sent;
+}
+
+static size_t chunk_size(int64_t remaining)
+{
+    return remaining < BUFFER_SIZE ? (size_t)remaining : BUFFER_SIZE;
+}
+
+static int transfer_pipelined(struct pipeline *p, int out_fd, int in_fd, int64_t offset, int64_t count, int64_t *sent)
+{
+    int error = 0;
+    int current = 0;
+
+    read_start(p, current, in_fd, offset, chunk_size(count));
+
+    for (;;)
+    {
+        int read_error;
+        ssize_t got = read_finish(p, &read_error);
+        if (got <= 0)
+        {
+            if (got < 0)
+                error = read_error;
+            break;
+        }
+
+        offset += got;
+        count -= got;
+
+        // The next chunk is read while this one is sent
+        bool prefetch = count > 0;
+        if (prefetch)
+            read_start(p, current ^ 1, in_fd, offset, chunk_size(count));
+
+        size_t done = send_all(out_fd, p->buffers[current], got, &error);
+        *sent += done;
+
+        if (done < (size_t)got || !prefetch)
+        {
+            // The reader must be done with the buffer before the pipeline is released
+            if (prefetch)
+                read_finish(p, &read_error);
+            break;
+        }
+
+        current ^= 1;
+    }
+
+    return error;
+}
+
+static unsigned char *direct_buffer_acquire()
+{
+    unsigned char *buffer = __atomic_exchange_n(&cached_buffer, NULL, __ATOMIC_ACQUIRE);
+    return buffer ? buffer : malloc(BUFFER_SIZE);
+}
+
+static void direct_buffer_release(unsigned char *buffer)
+{
+    unsigned char *expected = NULL;
+    if (!__atomic_compare_exchange_n(&cached_buffer, &expected, buffer, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        free(buffer);
+}
+
+// Small transfers and the ones that find no free pipeline read on the calling thread
+static int transfer_direct(unsigned char *buffer, int out_fd, int in_fd, int64_t offset, int64_t count, int64_t *sent)
+{
+    int error = 0;
+
+    while (count > 0)
+    {
+        ssize_t got;
+        while ((got = pread(in_fd, buffer, chunk_size(count), (off_t)offset)) < 0 && errno == EINTR);
+        if (got <= 0)
+        {
+            if (got < 0)
+                error = errno;
+            break;
+        }
+
+        size_t done = send_all(out_fd, buffer, got, &error);
+        *sent += done;
+        if (done < (size_t)got)
+            break;
+
+        offset += got;
+        count -= got;
+    }
+
+    return error;
+}
+
+int socket_sendfile(int out_fd, int in_fd, int64_t offset, int64_t count, int64_t *sent)
+{
+    *sent = 0;
+    if (count <= 0)
+        return 0;
+
+    int error;
+
+    // Pipelines and their reader threads are only for transfers that need more than one buffer
+    struct pipeline *p = count > BUFFER_SIZE ? pipeline_acquire() : NULL;
+
+    if (p)
+    {
+        error = transfer_pipelined(p, out_fd, in_fd, offset, count, sent);
+        pipeline_release(p);
+    }
+    else
+    {
+        unsigned char *buffer = direct_buffer_acquire();
+        if (!buffer)
+            return ENOMEM;
+
+        error = transfer_direct(buffer, out_fd, in_fd, offset, count, sent);
+        direct_buffer_release(buffer);
+    }
+
+    return *sent ? 0 : error;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// sendfile for SystemNative_SendFile, the PAL returns ENOTSUP on platforms without it.
+// Transfers larger than one buffer are pipelined: a reader thread fills one buffer from the file while the calling thread sends the other.
+// Same semantics as linux sendfile: the file position is not changed and a non blocking socket can return after a partial transfer.
+
+// Returns 0 or an errno value, sent is set in both cases. Errors after part of the data was sent are returned by the next call
+int socket_sendfile(int out_fd, int in_fd, int64_t offset, int64_t count, int64_t *sent);
@@ -0,0 +1,155 @@
+#include "thread_policy.h"
+#include "io_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <switch.h>
+#include <mono/metadata/profiler.h>
+
+// Name prefixes of the runtime threads, set by PortableThreadPool, SocketAsyncEngine and mono's gc.
+// The name is set either before the thread starts or by the thread itself, in both cases mono raises the callback on the thread.
+static const struct
+{
+    const char *prefix;
+    enum ThreadKind kind;
+} thread_names[] = {
+    { ".NET TP ", ThreadKind_Pool },
+    { ".NET Sockets", ThreadKind_Sockets },
+    { "Finalizer", ThreadKind_Gc },
+    { "SGen worker", ThreadKind_Gc },
+};
+
+static struct ThreadPolicy policies[ThreadKind_Count];
+
+static u32 process_core_mask()
+{
+    static u64 mask;
+    if (!mask && R_FAILED(svcGetInfo(&mask, InfoType_CoreMask, CUR_PROCESS_HANDLE, 0)))
+        return 0x7; // Cores 0 to 2 are the application cores
+    return (u32)mask;
+}
+
+bool thread_policy_parse_cores(const char *value, uint32_t *mask)
+{
+    uint32_t result = 0;
+
+    while (*value)
+    {
+        char *end;
+        long core = strtol(value, &end, 10);
+        if (end == value || core < 0 || core > 31)
+            return false;
+
+        result |= 1u << core;
+
+        while (*end == ' ')
+            end++;
+
+        if (*end == ',')
+            end++;
+        else if (*end)
+            return false;
+
+        value = end;
+    }
+
+    *mask = result;
+    return true;
+}
+
+bool thread_policy_set_current(uint32_t core_mask, int priority)
+{
+    bool ok = true;
+
+    if (core_mask)
+    {
+        u32 allowed = core_mask & process_core_mask();
+        if (!allowed)
+        {
+            io_debugf("thread_policy: none of the cores in %x can be used", core_mask);
+            return false;
+        }
+
+        // The ideal core must be part of the mask, keep the current one if possible so the thread doesn't move needlessly
+        s32 ideal;
+        u64 current_mask;
+        if (R_FAILED(svcGetThreadCoreMask(&ideal, &current_mask, CUR_THREAD_HANDLE)) || ideal < 0 || !(allowed & (1u << ideal)))
+            ideal = __builtin_ctz(allowed);
+
+        Result rc = svcSetThreadCoreMask(CUR_THREAD_HANDLE, ideal, allowed);
+        if (R_FAILED(rc))
+        {
+            io_debugf("thread_policy: svcSetThreadCoreMask(%d, %x) failed: %x", ideal, allowed, rc);
+            ok = false;
+        }
+    }
+
+    if (priority >= 0)
+    {
+        Result rc = svcSetThreadPriority(CUR_THREAD_HANDLE, priority);
+        if (R_FAILED(rc))
+        {
+            io_debugf("thread_policy: svcSetThreadPriority(%x) failed: %x", priority, rc);
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+bool thread_policy_get_current(uint32_t *core_mask, int *priority)
+{
+    s32 ideal, prio;
+    u64 mask;
+
+    if (R_FAILED(svcGetThreadCoreMask(&ideal, &mask, CUR_THREAD_HANDLE)) || R_FAILED(svcGetThreadPriority(&prio, CUR_THREAD_HANDLE)))
+        return false;
+
+    *core_mask = (uint32_t)mask;
+    *priority = prio;
+    return true;
+}
+
+static bool policy_is_set(enum ThreadKind kind)
+{
+    return policies[kind].core_mask || policies[kind].priority >= 0;
+}
+
+static void on_thread_name(MonoProfiler *prof, uintptr_t tid, const char *name)
+{
+    // Names set from another thread after the thread started can't be applied, we can only change the calling thread
+    if (!name || tid != (uintptr_t)pthread_self())
+        return;
+
+    for (size_t i = 0; i < sizeof(thread_names) / sizeof(thread_names[0]); i++)
+    {
+        if (strncmp(name, thread_names[i].prefix, strlen(thread_names[i].prefix)))
+            continue;
+
+        enum ThreadKind kind = thread_names[i].kind;
+        if (policy_is_set(kind))
+            thread_policy_set_current(policies[kind].core_mask, policies[kind].priority);
+
+        return;
+    }
+}
+
+void thread_policy_install(const struct ThreadPolicy *config)
+{
+    memcpy(policies, config, sizeof(policies));
+
+    if (policy_is_set(ThreadKind_Main) && thread_policy_set_current(policies[ThreadKind_Main].core_mask, policies[ThreadKind_Main].priority))
+        io_debugf("Main thread policy applied");
+
+    bool any = false;
+    for (int i = ThreadKind_Main + 1; i < ThreadKind_Count; i++)
+        any |= policy_is_set(i);
+
+    if (!any)
+        return;
+
+    MonoProfilerHandle handle = mono_profiler_create(NULL);
+    mono_profiler_set_thread_name_callback(handle, on_thread_name);
+}
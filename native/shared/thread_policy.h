@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Core masks and priorities for the threads of the runtime, configured in the [threads] section of config.ini.
+// Switch applications run on cores 0 to 2, lower priority values run first and 0x2C is the default of the main thread.
+// Runtime threads are recognized by the name mono gives them, see thread_policy.c
+
+enum ThreadKind
+{
+    // The thread that runs Main, usually the one that renders
+    ThreadKind_Main,
+    // Thread pool workers plus the gate and wait threads
+    ThreadKind_Pool,
+    // Finalizer and GC worker threads
+    ThreadKind_Gc,
+    // SocketAsyncEngine event loop
+    ThreadKind_Sockets,
+    ThreadKind_Count
+};
+
+struct ThreadPolicy
+{
+    // Bit n allows core n, 0 leaves the mask the thread was created with
+    uint32_t core_mask;
+    // Switch thread priority, -1 leaves it unchanged
+    int priority;
+};
+
+// Parses a comma separated list of cores like "1,2" into a mask, returns false for invalid lists
+bool thread_policy_parse_cores(const char *value, uint32_t *mask);
+
+// Applies the main thread policy to the calling thread and installs the mono callback that applies the others as threads are named.
+// Must be called from the main thread before mono_jit_init
+void thread_policy_install(const struct ThreadPolicy *policies);
+
+// Changes the calling thread, the mask is filtered with the cores available to the process. Returns false if nothing could be applied
+bool thread_policy_set_current(uint32_t core_mask, int priority);
+
+// Core mask and priority of the calling thread
+bool thread_policy_get_current(uint32_t *core_mask, int *priority);
@@ -0,0 +1,349 @@
+#ifndef __SWITCH__
+// pthread_getattr_np
+#define _GNU_SOURCE
+#endif
+
+#include "thread_stacks.h"
+#include "io_util.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#include <mono/metadata/profiler.h>
+#endif
+
+// Size PortableThreadPool asks for its threads, mono uses the same for its own small stack threads
+#define SMALL_STACK_SIZE (256 * 1024)
+
+// Size mono_thread_platform_create_thread uses on 64 bit when the creator doesn't ask for one
+#define MONO_DEFAULT_STACK_SIZE (2 * 1024 * 1024)
+
+#define STACK_ALIGN 0x1000
+#define STACK_PATTERN 0x5354414B5354414Bull
+
+// Space left unpainted below the frame of thread_start, it's in use while we paint
+#define PAINT_MARGIN 512
+
+// Exited threads are kept for the report, the oldest ones are dropped
+#define MAX_EXITED_RECORDS 64
+
+struct stack_record
+{
+    struct stack_record *next;
+    struct stack_record *prev;
+
+    enum ThreadStackKind kind;
+    char name[32];
+
+    uint64_t *low;
+    unsigned char *high;
+    size_t size;
+    size_t used;
+};
+
+struct thread_start
+{
+    void *(*routine)(void *);
+    void *arg;
+    enum ThreadStackKind kind;
+};
+
+static const char *kind_names[ThreadStackKind_Count] = { "managed", "pool", "gc", "native" };
+
+static bool enabled;
+static bool report_enabled;
+static size_t stack_sizes[ThreadStackKind_Count];
+static size_t default_stack_size;
+static volatile bool runtime_started;
+
+static pthread_mutex_t records_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct stack_record *live_records;
+static struct stack_record exited_records[MAX_EXITED_RECORDS];
+static int exited_count;
+static int threads_created[ThreadStackKind_Count];
+static size_t max_used[ThreadStackKind_Count];
+
+static pthread_key_t record_key;
+static __thread bool next_native;
+
+int __real_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start_routine)(void *), void *arg);
+
+static bool current_stack_bounds(unsigned char **low, unsigned char **high)
+{
+#ifdef __SWITCH__
+    Thread *self = threadGetSelf();
+    if (!self || !self->stack_mirror)
+        return false;
+
+    *low = self->stack_mirror;
+    *high = *low + self->stack_sz;
+    return true;
+#else
+    pthread_attr_t attr;
+    void *address;
+    size_t size;
+
+    if (pthread_getattr_np(pthread_self(), &attr))
+        return false;
+
+    int res = pthread_attr_getstack(&attr, &address, &size);
+    pthread_attr_destroy(&attr);
+    if (res)
+        return false;
+
+    *low = address;
+    *high = *low + size;
+    return true;
+#endif
+}
+
+// The stack grows down, the deepest point ever reached is the first word that lost the pattern
+static size_t stack_used(const struct stack_record *record)
+{
+    const uint64_t *word = record->low;
+    while ((unsigned char *)word < record->high && *word == STACK_PATTERN)
+        word++;
+
+    return record->high - (unsigned char *)word;
+}
+
+static void record_exit(struct stack_record *record)
+{
+    record->used = stack_used(record);
+
+    pthread_mutex_lock(&records_mutex);
+
+    if (record->prev)
+        record->prev->next = record->next;
+    else
+        live_records = record->next;
+    if (record->next)
+        record->next->prev = record->prev;
+
+    if (record->used > max_used[record->kind])
+        max_used[record->kind] = record->used;
+
+    exited_records[exited_count % MAX_EXITED_RECORDS] = *record;
+    exited_count++;
+
+    pthread_mutex_unlock(&records_mutex);
+
+    free(record);
+}
+
+// Runs for threads that end with pthread_exit instead of returning
+static void record_destructor(void *value)
+{
+    if (value)
+        record_exit(value);
+}
+
+static struct stack_record *record_start(enum ThreadStackKind kind)
+{
+    unsigned char *low, *high;
+    if (!current_stack_bounds(&low, &high))
+        return NULL;
+
+    struct stack_record *record = calloc(1, sizeof(struct stack_record));
+    if (!record)
+        return NULL;
+
+    record->kind = kind;
+    record->low = (uint64_t *)(((uintptr_t)low + 7) & ~(uintptr_t)7);
+    record->high = high;
+    record->size = high - low;
+
+    // Everything below our own frame is unused yet
+    uint64_t *end = (uint64_t *)(((uintptr_t)__builtin_frame_address(0) - PAINT_MARGIN) & ~(uintptr_t)7);
+    for (volatile uint64_t *word = record->low; word < end; word++)
+        *word = STACK_PATTERN;
+
+    pthread_mutex_lock(&records_mutex);
+    record->next = live_records;
+    if (live_records)
+        live_records->prev = record;
+    live_records = record;
+    pthread_mutex_unlock(&records_mutex);
+
+    pthread_setspecific(record_key, record);
+    return record;
+}
+
+static void *thread_start(void *param)
+{
+    struct thread_start start = *(struct thread_start *)param;
+    free(param);
+
+    struct stack_record *record = report_enabled ? record_start(start.kind) : NULL;
+
+    void *result = start.routine(start.arg);
+
+    if (record)
+    {
+        pthread_setspecific(record_key, NULL);
+        record_exit(record);
+    }
+
+    return result;
+}
+
+static enum ThreadStackKind classify(const pthread_attr_t *attr, size_t requested)
+{
+    if (next_native)
+        return ThreadStackKind_Native;
+
+    // Mono always passes attributes, falling back to the default size when none was asked
+    if (!attr)
+        return ThreadStackKind_Native;
+
+    if (!runtime_started)
+        return ThreadStackKind_Gc;
+
+    if (requested == SMALL_STACK_SIZE)
+        return ThreadStackKind_Pool;
+
+    return ThreadStackKind_Managed;
+}
+
+// The creator didn't pick a size, new Thread without maxStackSize ends up with mono's default
+static bool is_default_size(const pthread_attr_t *attr, size_t requested)
+{
+    return !attr || requested == default_stack_size || requested == MONO_DEFAULT_STACK_SIZE;
+}
+
+int __wrap_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start_routine)(void *), void *arg)
+{
+    if (!enabled)
+        return __real_pthread_create(thread, attr, start_routine, arg);
+
+    size_t requested = 0;
+    if (attr)
+        pthread_attr_getstacksize(attr, &requested);
+
+    enum ThreadStackKind kind = classify(attr, requested);
+
+    struct thread_start *start = malloc(sizeof(struct thread_start));
+    if (!start)
+        return __real_pthread_create(thread, attr, start_routine, arg);
+
+    start->routine = start_routine;
+    start->arg = arg;
+    start->kind = kind;
+
+    pthread_attr_t copy;
+    if (attr)
+        copy = *attr;
+    else
+        pthread_attr_init(&copy);
+
+    // Pool and gc threads get the sizes the runtime picks for itself, a size chosen by the app is kept since deep recursion may depend on it
+    bool runtime_size = kind == ThreadStackKind_Pool || kind == ThreadStackKind_Gc;
+    if (stack_sizes[kind] && (runtime_size || is_default_size(attr, requested)))
+        pthread_attr_setstacksize(&copy, stack_sizes[kind]);
+
+    int res = __real_pthread_create(thread, &copy, thread_start, start);
+    if (res)
+        free(start);
+    else
+        __atomic_fetch_add(&threads_created[kind], 1, __ATOMIC_RELAXED);
+
+    if (!attr)
+        pthread_attr_destroy(&copy);
+
+    return res;
+}
+
+#ifdef __SWITCH__
+static void on_thread_name(MonoProfiler *prof, uintptr_t tid, const char *name)
+{
+    struct stack_record *record = pthread_getspecific(record_key);
+    if (!name || !record || tid != (uintptr_t)pthread_self())
+        return;
+
+    snprintf(record->name, sizeof(record->name), "%s", name);
+}
+#endif
+
+void thread_stacks_initialize(const size_t *sizes, bool report)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_getstacksize(&attr, &default_stack_size);
+    pthread_attr_destroy(&attr);
+
+    bool any_size = false;
+    for (int i = 0; i < ThreadStackKind_Count; i++)
+    {
+        // libnx wants page aligned stacks
+        stack_sizes[i] = (sizes[i] + STACK_ALIGN - 1) & ~(size_t)(STACK_ALIGN - 1);
+        any_size |= stack_sizes[i] != 0;
+    }
+
+    report_enabled = report && pthread_key_create(&record_key, record_destructor) == 0;
+    enabled = any_size || report_enabled;
+
+#ifdef __SWITCH__
+    // Names make the report readable, mono raises the callback on the thread being named
+    if (report_enabled)
+    {
+        MonoProfilerHandle handle = mono_profiler_create(NULL);
+        mono_profiler_set_thread_name_callback(handle, on_thread_name);
+    }
+#endif
+}
+
+void thread_stacks_runtime_started()
+{
+    runtime_started = true;
+}
+
+void thread_stacks_next_is_native(bool native)
+{
+    next_native = native;
+}
+
+static void print_record(const struct stack_record *record, size_t used, const char *state)
+{
+    io_debugf("%-24s %-8s %8zu KB %8zu KB %s", record->name[0] ? record->name : "(unnamed)", kind_names[record->kind],
+        record->size / 1024, used / 1024, state);
+}
+
+void thread_stacks_report()
+{
+    if (!report_enabled)
+        return;
+
+    pthread_mutex_lock(&records_mutex);
+
+    size_t kind_max[ThreadStackKind_Count];
+    memcpy(kind_max, max_used, sizeof(kind_max));
+
+    io_debugf("--- thread stacks ---");
+    io_debugf("%-24s %-8s %11s %11s", "thread", "kind", "stack", "used");
+
+    for (struct stack_record *record = live_records; record; record = record->next)
+    {
+        size_t used = stack_used(record);
+        if (used > kind_max[record->kind])
+            kind_max[record->kind] = used;
+        print_record(record, used, "live");
+    }
+
+    int first = exited_count > MAX_EXITED_RECORDS ? exited_count - MAX_EXITED_RECORDS : 0;
+    for (int i = first; i < exited_count; i++)
+    {
+        const struct stack_record *record = &exited_records[i % MAX_EXITED_RECORDS];
+        print_record(record, record->used, "exited");
+    }
+
+    for (int i = 0; i < ThreadStackKind_Count; i++)
+        io_debugf("%-8s threads: %d configured: %zu KB max used: %zu KB", kind_names[i], threads_created[i], stack_sizes[i] / 1024, kind_max[i] / 1024);
+
+    io_debugf("---------------------");
+
+    pthread_mutex_unlock(&records_mutex);
+}
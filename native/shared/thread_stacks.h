@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Stack sizes of the threads created with pthread_create, configured in the [threads] section of config.ini.
+// Thread stacks come from the heap on switch, so the runtime defaults add up quickly with many threads.
+// The launchers are linked with --wrap=pthread_create so every thread, from mono or from native libraries, goes through here.
+// When the report is enabled each stack is filled with a pattern on start, the untouched part left at the end gives the high-water mark.
+
+enum ThreadStackKind
+{
+    // Threads started by managed code through mono
+    ThreadStackKind_Managed,
+    // Thread pool workers and the other threads mono creates with its small stack size after startup
+    ThreadStackKind_Pool,
+    // Threads mono creates while it starts, the finalizer and the GC workers
+    ThreadStackKind_Gc,
+    // SystemNative_CreateThread and native libraries that create threads without attributes
+    ThreadStackKind_Native,
+    ThreadStackKind_Count
+};
+
+// sizes are in bytes indexed by enum ThreadStackKind, 0 keeps the size asked by the creator.
+// Managed and native threads only get the configured size when the creator left the default, explicit sizes are kept
+void thread_stacks_initialize(const size_t *sizes, bool report);
+
+// Threads created until this is called are classified as ThreadStackKind_Gc, call it after mono_jit_init
+void thread_stacks_runtime_started();
+
+// The next pthread_create on this thread creates a native helper thread, used by the SystemNative_CreateThread hook
+void thread_stacks_next_is_native(bool native);
+
+// Prints the stack size and high-water mark of every thread, live or exited, and the maximum per kind
+void thread_stacks_report();
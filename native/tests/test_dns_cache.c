@@ -0,0 +1,254 @@
+#include "dns_cache.h"
+#include "test.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Stand-in for SystemNative_GetHostEntryForName: names containing "missing" don't exist, "offline" fails like a network error.
+// Every call is counted and the entry is allocated the way the PAL does it
+static int resolver_calls;
+static pthread_mutex_t resolver_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// When set the resolver waits for two callers, to make concurrent misses overlap
+static pthread_barrier_t *resolver_barrier;
+
+static int32_t fake_resolve(const uint8_t *name, int32_t family, HostEntry *entry)
+{
+    pthread_mutex_lock(&resolver_mutex);
+    resolver_calls++;
+    pthread_mutex_unlock(&resolver_mutex);
+
+    if (resolver_barrier)
+        pthread_barrier_wait(resolver_barrier);
+
+    memset(entry, 0, sizeof(HostEntry));
+    if (strstr((const char *)name, "missing"))
+        return DNS_RESULT_NONAME;
+    if (strstr((const char *)name, "offline"))
+        return 2;
+
+    entry->CanonicalName = (uint8_t *)strdup((const char *)name);
+    entry->AliasCount = 2;
+    entry->Aliases = calloc(3, sizeof(uint8_t *));
+    entry->Aliases[0] = (uint8_t *)strdup("alias0");
+    entry->Aliases[1] = (uint8_t *)strdup("alias1");
+    entry->IPAddressCount = 2;
+    entry->IPAddressList = calloc(2, sizeof(IPAddress));
+    entry->IPAddressList[0].Address[0] = 10;
+    entry->IPAddressList[0].Address[3] = (uint8_t)family;
+    entry->IPAddressList[1].IsIPv6 = 1;
+    return 0;
+}
+
+// Same as SystemNative_FreeHostEntry
+static void free_entry(HostEntry *entry)
+{
+    free(entry->CanonicalName);
+    for (int i = 0; i < entry->AliasCount; i++)
+        free(entry->Aliases[i]);
+    free(entry->Aliases);
+    free(entry->IPAddressList);
+}
+
+static int calls()
+{
+    pthread_mutex_lock(&resolver_mutex);
+    int result = resolver_calls;
+    resolver_calls = 0;
+    pthread_mutex_unlock(&resolver_mutex);
+    return result;
+}
+
+static int32_t resolve(const char *name, int32_t family)
+{
+    HostEntry entry;
+    int32_t result = dns_cache_resolve((const uint8_t *)name, family, &entry, fake_resolve);
+    if (result == 0)
+    {
+        CHECK(entry.CanonicalName && strcasecmp((const char *)entry.CanonicalName, name) == 0);
+        CHECK(entry.AliasCount == 2 && strcmp((const char *)entry.Aliases[1], "alias1") == 0);
+        CHECK(entry.IPAddressCount == 2 && entry.IPAddressList[0].Address[3] == family && entry.IPAddressList[1].IsIPv6);
+        free_entry(&entry);
+    }
+    else
+        CHECK(entry.CanonicalName == NULL && entry.IPAddressCount == 0);
+    return result;
+}
+
+static struct DnsCacheStats get_stats()
+{
+    struct DnsCacheStats stats;
+    dns_cache_get_stats(&stats);
+    return stats;
+}
+
+static void test_hits()
+{
+    dns_cache_configure(60, 10, 8);
+    calls();
+
+    CHECK(resolve("Host.example", 0) == 0);
+    CHECK(resolve("host.EXAMPLE", 0) == 0);
+    CHECK(calls() == 1);
+
+    // The family is part of the key
+    CHECK(resolve("host.example", 2) == 0);
+    CHECK(calls() == 1);
+
+    // Empty names are never cached
+    CHECK(resolve("", 0) == 0);
+    CHECK(resolve("", 0) == 0);
+    CHECK(calls() == 2);
+
+    struct DnsCacheStats stats = get_stats();
+    CHECK(stats.hits == 1 && stats.misses == 2 && stats.entries == 2 && stats.capacity == 8);
+}
+
+static void test_negative()
+{
+    dns_cache_configure(60, 10, 8);
+    calls();
+
+    CHECK(resolve("missing.example", 0) == DNS_RESULT_NONAME);
+    CHECK(resolve("missing.example", 0) == DNS_RESULT_NONAME);
+    CHECK(calls() == 1);
+    CHECK(get_stats().negative_hits >= 1);
+
+    // Other errors may go away on their own
+    CHECK(resolve("offline.example", 0) == 2);
+    CHECK(resolve("offline.example", 0) == 2);
+    CHECK(calls() == 2);
+
+    // No negative ttl, nothing is remembered
+    dns_cache_configure(60, 0, 8);
+    calls();
+    CHECK(resolve("missing.example", 0) == DNS_RESULT_NONAME);
+    CHECK(resolve("missing.example", 0) == DNS_RESULT_NONAME);
+    CHECK(calls() == 2);
+}
+
+static void test_expiry()
+{
+    dns_cache_configure(1, 1, 8);
+    calls();
+
+    CHECK(resolve("host.example", 0) == 0);
+    CHECK(resolve("missing.example", 0) == DNS_RESULT_NONAME);
+    CHECK(resolve("host.example", 0) == 0);
+    CHECK(resolve("missing.example", 0) == DNS_RESULT_NONAME);
+    CHECK(calls() == 2);
+
+    usleep(1100 * 1000);
+
+    CHECK(resolve("host.example", 0) == 0);
+    CHECK(resolve("missing.example", 0) == DNS_RESULT_NONAME);
+    CHECK(calls() == 2);
+
+    // A ttl of 0 disables the cache
+    dns_cache_configure(0, 0, 8);
+    CHECK(resolve("host.example", 0) == 0);
+    CHECK(resolve("host.example", 0) == 0);
+    CHECK(calls() == 2);
+}
+
+static void test_eviction()
+{
+    dns_cache_configure(60, 10, 3);
+    calls();
+
+    CHECK(resolve("a.example", 0) == 0);
+    CHECK(resolve("b.example", 0) == 0);
+    CHECK(resolve("c.example", 0) == 0);
+
+    // a becomes the most recently used, b is the oldest
+    usleep(5 * 1000);
+    CHECK(resolve("a.example", 0) == 0);
+    CHECK(resolve("d.example", 0) == 0);
+    CHECK(calls() == 4);
+
+    struct DnsCacheStats stats = get_stats();
+    CHECK(stats.entries == 3 && stats.evictions == 1);
+
+    CHECK(resolve("a.example", 0) == 0);
+    CHECK(resolve("c.example", 0) == 0);
+    CHECK(resolve("d.example", 0) == 0);
+    CHECK(calls() == 0);
+    CHECK(resolve("b.example", 0) == 0);
+    CHECK(calls() == 1);
+
+    dns_cache_clear();
+    CHECK(get_stats().entries == 0);
+    CHECK(resolve("a.example", 0) == 0);
+    CHECK(calls() == 1);
+}
+
+static void *concurrent_miss(void *param)
+{
+    CHECK(resolve("shared.example", 0) == 0);
+    return NULL;
+}
+
+static void test_concurrent_miss()
+{
+    dns_cache_configure(60, 10, 8);
+    calls();
+
+    // Both threads are inside the resolver at the same time, both resolve and only one entry is kept
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, 2);
+    resolver_barrier = &barrier;
+
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++)
+        pthread_create(&threads[i], NULL, concurrent_miss, NULL);
+    for (int i = 0; i < 2; i++)
+        pthread_join(threads[i], NULL);
+
+    resolver_barrier = NULL;
+    pthread_barrier_destroy(&barrier);
+
+    CHECK(calls() == 2);
+    CHECK(get_stats().entries == 1);
+    CHECK(resolve("shared.example", 0) == 0);
+    CHECK(calls() == 0);
+}
+
+static void *stress(void *param)
+{
+    char name[32];
+    for (int i = 0; i < 20000; i++)
+    {
+        snprintf(name, sizeof(name), "host%d.example", (i * 7 + (int)(intptr_t)param) % 12);
+        CHECK(resolve(name, 0) == 0);
+    }
+    return NULL;
+}
+
+// More names than entries, every thread keeps evicting what the others cached
+static void test_stress()
+{
+    dns_cache_configure(60, 10, 8);
+
+    pthread_t threads[8];
+    for (intptr_t i = 0; i < 8; i++)
+        pthread_create(&threads[i], NULL, stress, (void *)i);
+    for (int i = 0; i < 8; i++)
+        pthread_join(threads[i], NULL);
+
+    CHECK(get_stats().entries <= 8);
+}
+
+int main()
+{
+    test_hits();
+    test_negative();
+    test_expiry();
+    test_eviction();
+    test_concurrent_miss();
+    test_stress();
+
+    dns_cache_configure(0, 0, 0);
+    printf("dns_cache: ok\n");
+    return 0;
+}
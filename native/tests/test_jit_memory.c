@@ -0,0 +1,167 @@
+#include "jit_memory.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#define REGION_SIZE (1024 * 1024)
+#define PAGE_SIZE 0x1000
+
+typedef int (*return_fn)(void);
+
+// Writes a function that returns value through the RW view and returns the RX address to call
+static return_fn emit_return(int value)
+{
+    void *rw;
+    unsigned char *rx = mono_nx_code_alloc(16, &rw);
+    if (!rx)
+        return NULL;
+
+    unsigned char *code = rw;
+#if defined(__x86_64__) || defined(__i386__)
+    // mov eax, value; ret
+    code[0] = 0xB8;
+    memcpy(code + 1, &value, 4);
+    code[5] = 0xC3;
+#elif defined(__aarch64__)
+    // movz w0, #value; ret
+    uint32_t insns[2] = { 0x52800000 | ((uint32_t)(value & 0xFFFF) << 5), 0xD65F03C0 };
+    memcpy(code, insns, sizeof(insns));
+#else
+#error "No test code for this architecture"
+#endif
+
+    mono_nx_code_flush(rx, 16);
+    return (return_fn)rx;
+}
+
+static void test_views()
+{
+    void *rw;
+    unsigned char *rx = mono_nx_code_alloc(3 * PAGE_SIZE, &rw);
+    CHECK(rx && rw && (void *)rx != rw);
+
+    // Both views are the same memory
+    memset(rw, 0x5A, 3 * PAGE_SIZE);
+    CHECK(rx[0] == 0x5A && rx[3 * PAGE_SIZE - 1] == 0x5A);
+
+    CHECK(mono_nx_code_rw(rx) == rw);
+    CHECK(mono_nx_code_rx(rw) == rx);
+    CHECK(mono_nx_code_rw(rx + 100) == (unsigned char *)rw + 100);
+    CHECK(mono_nx_code_rx((unsigned char *)rw + 100) == rx + 100);
+
+    int not_jit;
+    CHECK(mono_nx_code_rw(&not_jit) == NULL);
+    CHECK(mono_nx_code_rx(&not_jit) == NULL);
+
+    // Frees that don't match a chunk are ignored
+    mono_nx_code_free(rx + PAGE_SIZE);
+    mono_nx_code_free(&not_jit);
+
+    mono_nx_code_free(rx);
+    CHECK(mono_nx_code_alloc(0, &rw) == NULL);
+}
+
+static void test_execute()
+{
+    return_fn f = emit_return(1234);
+    CHECK(f && f() == 1234);
+
+    // Code rewritten in place runs the new version after a flush
+    return_fn g = emit_return(1);
+    CHECK(g && g() == 1);
+    mono_nx_code_free((void *)g);
+
+    return_fn h = emit_return(2);
+    CHECK(h == g && h() == 2);
+
+    mono_nx_code_free((void *)f);
+    mono_nx_code_free((void *)h);
+}
+
+// Regions are added on demand up to the limit given to jit_memory_initialize, then allocations fail
+static void test_regions()
+{
+    void *chunks[2];
+    void *rw;
+    for (int i = 0; i < 2; i++)
+        CHECK((chunks[i] = mono_nx_code_alloc(REGION_SIZE, &rw)) != NULL);
+
+    CHECK(mono_nx_code_alloc(PAGE_SIZE, &rw) == NULL);
+    CHECK(mono_nx_code_alloc(REGION_SIZE + PAGE_SIZE, &rw) == NULL);
+
+    mono_nx_code_free(chunks[0]);
+    CHECK(mono_nx_code_alloc(PAGE_SIZE, &rw) == chunks[0]);
+    mono_nx_code_free(chunks[0]);
+    mono_nx_code_free(chunks[1]);
+}
+
+#define CHURN_THREADS 4
+#define CHURN_ROUNDS 2000
+#define CHURN_LIVE 8
+
+static void *churn(void *param)
+{
+    int id = (int)(intptr_t)param;
+    return_fn live[CHURN_LIVE] = { 0 };
+    int values[CHURN_LIVE];
+    unsigned seed = id;
+
+    for (int round = 0; round < CHURN_ROUNDS; round++)
+    {
+        int slot = rand_r(&seed) % CHURN_LIVE;
+        if (live[slot])
+        {
+            CHECK(live[slot]() == values[slot]);
+            mono_nx_code_free((void *)live[slot]);
+            live[slot] = NULL;
+        }
+        else
+        {
+            values[slot] = id * 10000 + round;
+            live[slot] = emit_return(values[slot]);
+            CHECK(live[slot] != NULL);
+        }
+    }
+
+    for (int i = 0; i < CHURN_LIVE; i++)
+    {
+        if (live[i])
+        {
+            CHECK(live[i]() == values[i]);
+            mono_nx_code_free((void *)live[i]);
+        }
+    }
+
+    return NULL;
+}
+
+static void test_churn()
+{
+    pthread_t threads[CHURN_THREADS];
+    for (intptr_t i = 0; i < CHURN_THREADS; i++)
+        pthread_create(&threads[i], NULL, churn, (void *)i);
+    for (int i = 0; i < CHURN_THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    // Everything was freed, a whole region fits again
+    void *rw;
+    void *all = mono_nx_code_alloc(REGION_SIZE, &rw);
+    CHECK(all != NULL);
+    mono_nx_code_free(all);
+}
+
+int main()
+{
+    CHECK(jit_memory_initialize(REGION_SIZE, 2));
+
+    test_views();
+    test_execute();
+    test_regions();
+    test_churn();
+
+    jit_memory_dispose();
+    printf("jit_memory: ok\n");
+    return 0;
+}
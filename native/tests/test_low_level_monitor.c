@@ -0,0 +1,142 @@
+#include "low_level_monitor.h"
+#include "test.h"
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+static LowLevelMonitor *monitor;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_timed_wait()
+{
+    monitor = low_level_monitor_create();
+    CHECK(monitor);
+
+    low_level_monitor_acquire(monitor);
+    double start = now();
+    CHECK(low_level_monitor_timed_wait(monitor, 50) == 0);
+    CHECK(now() - start >= 0.049);
+    low_level_monitor_release(monitor);
+
+    low_level_monitor_destroy(monitor);
+}
+
+#define HANDOFF_THREADS 4
+#define HANDOFF_ROUNDS 100000
+
+static long counter;
+
+// The counter is only consistent if acquire excludes the other threads, spinning or not
+static void *handoff(void *param)
+{
+    for (int i = 0; i < HANDOFF_ROUNDS; i++)
+    {
+        low_level_monitor_acquire(monitor);
+        counter++;
+        low_level_monitor_release(monitor);
+    }
+    return NULL;
+}
+
+#define PINGPONG_ROUNDS 20000
+
+static int turn;
+
+static void *pingpong(void *param)
+{
+    int me = (int)(intptr_t)param;
+    for (int i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+        low_level_monitor_acquire(monitor);
+        while (turn != me)
+            low_level_monitor_wait(monitor);
+        turn = !me;
+        low_level_monitor_signal_release(monitor);
+    }
+    return NULL;
+}
+
+struct signaled
+{
+    bool waiting;
+    bool ready;
+    int32_t result;
+};
+
+// Waits with a long timeout, spurious wakeups just wait again
+static void *timed_waiter(void *param)
+{
+    struct signaled *state = param;
+    low_level_monitor_acquire(monitor);
+    state->waiting = true;
+    while (!state->ready)
+    {
+        state->result = low_level_monitor_timed_wait(monitor, 10000);
+        if (!state->result)
+            break;
+    }
+    low_level_monitor_release(monitor);
+    return NULL;
+}
+
+static void run(int max_spin)
+{
+    low_level_monitor_initialize(true, max_spin);
+    CHECK(low_level_monitor_enabled());
+    monitor = low_level_monitor_create();
+
+    counter = 0;
+    pthread_t threads[HANDOFF_THREADS];
+    for (int i = 0; i < HANDOFF_THREADS; i++)
+        pthread_create(&threads[i], NULL, handoff, NULL);
+    for (int i = 0; i < HANDOFF_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    CHECK(counter == (long)HANDOFF_THREADS * HANDOFF_ROUNDS);
+
+    turn = 0;
+    for (intptr_t i = 0; i < 2; i++)
+        pthread_create(&threads[i], NULL, pingpong, (void *)i);
+    for (int i = 0; i < 2; i++)
+        pthread_join(threads[i], NULL);
+
+    // A signal wakes a timed wait before its timeout and the wait reports that it was woken
+    struct signaled state = { 0 };
+    pthread_create(&threads[0], NULL, timed_waiter, &state);
+    for (bool signaled = false; !signaled;)
+    {
+        low_level_monitor_acquire(monitor);
+        if (state.waiting)
+        {
+            state.ready = true;
+            low_level_monitor_signal_release(monitor);
+            signaled = true;
+        }
+        else
+            low_level_monitor_release(monitor);
+    }
+    pthread_join(threads[0], NULL);
+    CHECK(state.result == 1);
+
+    low_level_monitor_destroy(monitor);
+}
+
+int main()
+{
+    low_level_monitor_initialize(false, 0);
+    CHECK(!low_level_monitor_enabled());
+
+    test_timed_wait();
+    run(0);
+    run(100);
+    run(1000);
+
+    printf("low_level_monitor: ok\n");
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Includes the source to check the static ChaCha20 block function against the RFC 7539 test vectors
+#include "../shared/secure_random.c"
+#include "test.h"
+
+#include <stdio.h>
+
+static void test_chacha20()
+{
+    // RFC 7539 A.1, test vectors 1 and 2: all zero key and nonce, block counter 0 and 1
+    static const uint8_t block0[BLOCK_SIZE] = {
+        0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90, 0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28,
+        0xbd, 0xd2, 0x19, 0xb8, 0xa0, 0x8d, 0xed, 0x1a, 0xa8, 0x36, 0xef, 0xcc, 0x8b, 0x77, 0x0d, 0xc7,
+        0xda, 0x41, 0x59, 0x7c, 0x51, 0x57, 0x48, 0x8d, 0x77, 0x24, 0xe0, 0x3f, 0xb8, 0xd8, 0x4a, 0x37,
+        0x6a, 0x43, 0xb8, 0xf4, 0x15, 0x18, 0xa1, 0x1c, 0xc3, 0x87, 0xb6, 0x69, 0xb2, 0xee, 0x65, 0x86,
+    };
+    static const uint8_t block1[BLOCK_SIZE] = {
+        0x9f, 0x07, 0xe7, 0xbe, 0x55, 0x51, 0x38, 0x7a, 0x98, 0xba, 0x97, 0x7c, 0x73, 0x2d, 0x08, 0x0d,
+        0xcb, 0x0f, 0x29, 0xa0, 0x48, 0xe3, 0x65, 0x69, 0x12, 0xc6, 0x53, 0x3e, 0x32, 0xee, 0x7a, 0xed,
+        0x29, 0xb7, 0x21, 0x76, 0x9c, 0xe6, 0x4e, 0x43, 0xd5, 0x71, 0x33, 0xb0, 0x74, 0xd8, 0x39, 0xd5,
+        0x31, 0xed, 0x1f, 0x28, 0x51, 0x0a, 0xfb, 0x45, 0xac, 0xe1, 0x0a, 0x1f, 0x4b, 0x79, 0x4d, 0x6f,
+    };
+
+    uint32_t key[8] = { 0 };
+    uint8_t out[BLOCK_SIZE];
+
+    chacha20_block(key, 0, out);
+    CHECK(memcmp(out, block0, BLOCK_SIZE) == 0);
+
+    chacha20_block(key, 1, out);
+    CHECK(memcmp(out, block1, BLOCK_SIZE) == 0);
+}
+
+static void test_disabled()
+{
+    uint8_t buffer[16];
+    secure_random_initialize(false);
+    CHECK(secure_random_bytes(buffer, sizeof(buffer)) == -1);
+    secure_random_initialize(true);
+}
+
+static void test_sizes()
+{
+    static uint8_t buffer[5000];
+    CHECK(secure_random_bytes(buffer, 0) == 0);
+
+    // Sizes that end inside, at and across the end of the buffer
+    for (size_t size = 1; size < sizeof(buffer); size += 97)
+        CHECK(secure_random_bytes(buffer, size) == 0);
+
+    uint8_t a[16], b[16];
+    CHECK(secure_random_bytes(a, sizeof(a)) == 0);
+    CHECK(secure_random_bytes(b, sizeof(b)) == 0);
+    CHECK(memcmp(a, b, sizeof(a)) != 0);
+}
+
+// 8 MB goes through several reseeds, the byte counts must look uniform
+static void test_distribution()
+{
+    size_t size = 8 * 1024 * 1024;
+    uint8_t *buffer = malloc(size);
+    CHECK(buffer && secure_random_bytes(buffer, size) == 0);
+
+    long counts[256] = { 0 };
+    for (size_t i = 0; i < size; i++)
+        counts[buffer[i]]++;
+    free(buffer);
+
+    double expected = size / 256.0, chi2 = 0;
+    for (int i = 0; i < 256; i++)
+        chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+
+    // 255 degrees of freedom, this fails with a probability well below one in a million
+    CHECK(chi2 < 400);
+}
+
+#define THREADS 8
+
+static uint8_t thread_first[THREADS][32];
+
+// Every thread gets its own generator and a different seed
+static void *thread_main(void *param)
+{
+    int id = (int)(intptr_t)param;
+    CHECK(secure_random_bytes(thread_first[id], sizeof(thread_first[id])) == 0);
+
+    uint8_t buffer[16];
+    for (int i = 0; i < 100000; i++)
+        CHECK(secure_random_bytes(buffer, sizeof(buffer)) == 0);
+    return NULL;
+}
+
+static void test_threads()
+{
+    pthread_t threads[THREADS];
+    for (intptr_t i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, thread_main, (void *)i);
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    for (int i = 0; i < THREADS; i++)
+        for (int j = i + 1; j < THREADS; j++)
+            CHECK(memcmp(thread_first[i], thread_first[j], sizeof(thread_first[i])) != 0);
+}
+
+int main()
+{
+    test_chacha20();
+    test_disabled();
+    test_sizes();
+    test_distribution();
+    test_threads();
+
+    printf("secure_random: ok\n");
+    return 0;
+}
@@ -0,0 +1,342 @@
+#include "socket_event_port.h"
+#include "test.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Loopback socket pairs stand in for the sockets of the runtime. wait blocks until something is ready, so to check that a
+// socket is not reported the tests register a sentinel that is always writable and check that only the sentinel comes back
+#define SENTINEL_DATA 999
+
+static struct socket_event_port *port;
+static int sentinel[2];
+
+static void set_nonblocking(int fd)
+{
+    CHECK(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0);
+}
+
+static void make_pair(int fds[2])
+{
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    for (int i = 0; i < 2; i++)
+        set_nonblocking(fds[i]);
+}
+
+static void close_pair(int fds[2])
+{
+    for (int i = 0; i < 2; i++)
+    {
+        socket_event_port_forget(fds[i]);
+        close(fds[i]);
+    }
+}
+
+static int wait_events(struct socket_event *events, int32_t capacity)
+{
+    int32_t count = capacity;
+    CHECK(socket_event_port_wait(port, events, &count) == 0);
+    CHECK(count > 0 && count <= capacity);
+    return count;
+}
+
+// Returns the events reported for data, failing if anything other than it and the sentinel was reported
+static int32_t events_for(uintptr_t data)
+{
+    CHECK(socket_event_port_change(port, sentinel[0], SOCKET_EVENT_WRITE, SENTINEL_DATA) == 0);
+
+    struct socket_event events[8];
+    int count = wait_events(events, 8);
+
+    int32_t result = 0;
+    bool sentinel_seen = false;
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].data == SENTINEL_DATA)
+            sentinel_seen = true;
+        else
+        {
+            CHECK(events[i].data == data);
+            result |= events[i].events;
+        }
+    }
+
+    CHECK(sentinel_seen);
+    CHECK(socket_event_port_change(port, sentinel[0], 0, 0) == 0);
+    return result;
+}
+
+// TCP over loopback completes in the kernel soon after the call but not necessarily before it returns
+static int32_t wait_for(uintptr_t data, int32_t expected)
+{
+    int32_t result = 0;
+    for (int i = 0; i < 1000 && (result & expected) != expected; i++)
+    {
+        if (i)
+            usleep(1000);
+        result |= events_for(data);
+    }
+
+    CHECK((result & expected) == expected);
+    return result;
+}
+
+static void drain(int fd)
+{
+    char buffer[256];
+    while (recv(fd, buffer, sizeof(buffer), 0) > 0);
+    CHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+// An event is reported once and stays masked until an operation returns EAGAIN and rearms it
+static void test_one_shot_and_rearm()
+{
+    int fds[2];
+    make_pair(fds);
+
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_READ, 1) == 0);
+    CHECK(events_for(1) == 0);
+
+    CHECK(send(fds[1], "x", 1, 0) == 1);
+    CHECK(events_for(1) == SOCKET_EVENT_READ);
+
+    // Still readable but already reported, like an edge triggered epoll
+    CHECK(events_for(1) == 0);
+
+    // The runtime reads until EAGAIN, the hooks rearm the socket then
+    drain(fds[0]);
+    socket_event_port_rearm(fds[0], SOCKET_EVENT_READ);
+    CHECK(events_for(1) == 0);
+
+    CHECK(send(fds[1], "y", 1, 0) == 1);
+    CHECK(events_for(1) == SOCKET_EVENT_READ);
+
+    // Rearming for writes doesn't affect a socket only registered for reads
+    drain(fds[0]);
+    socket_event_port_rearm(fds[0], SOCKET_EVENT_WRITE);
+    CHECK(send(fds[1], "z", 1, 0) == 1);
+    CHECK(events_for(1) == 0);
+
+    close_pair(fds);
+}
+
+// Changing the registration reports the current state again
+static void test_change_reports_again()
+{
+    int fds[2];
+    make_pair(fds);
+
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_READ | SOCKET_EVENT_WRITE, 2) == 0);
+    CHECK(events_for(2) == SOCKET_EVENT_WRITE);
+    CHECK(events_for(2) == 0);
+
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_READ | SOCKET_EVENT_WRITE, 3) == 0);
+    CHECK(events_for(3) == SOCKET_EVENT_WRITE);
+
+    // Removed sockets are not reported
+    CHECK(socket_event_port_change(port, fds[0], 0, 0) == 0);
+    CHECK(send(fds[1], "x", 1, 0) == 1);
+    CHECK(events_for(3) == 0);
+
+    close_pair(fds);
+}
+
+static void test_hangup()
+{
+    int fds[2];
+    make_pair(fds);
+
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_READ, 4) == 0);
+    socket_event_port_forget(fds[1]);
+    close(fds[1]);
+
+    int32_t events = events_for(4);
+    CHECK(events & SOCKET_EVENT_READ);
+    CHECK(events & SOCKET_EVENT_CLOSE);
+
+    // Closed sockets are not armed again by a registration of something else
+    CHECK(events_for(4) == 0);
+
+    socket_event_port_forget(fds[0]);
+    close(fds[0]);
+}
+
+// Forgotten sockets leave the poll set and their number can be reused right away
+static void test_forget()
+{
+    int fds[2];
+    make_pair(fds);
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_WRITE, 5) == 0);
+    close_pair(fds);
+
+    int reused[2];
+    make_pair(reused);
+    CHECK(events_for(5) == 0);
+
+    CHECK(socket_event_port_change(port, reused[0], SOCKET_EVENT_WRITE, 6) == 0);
+    CHECK(events_for(6) == SOCKET_EVENT_WRITE);
+    close_pair(reused);
+}
+
+struct waiter
+{
+    struct socket_event event;
+    int32_t count;
+    int result;
+};
+
+static void *wait_thread(void *param)
+{
+    struct waiter *waiter = param;
+    waiter->count = 1;
+    waiter->result = socket_event_port_wait(port, &waiter->event, &waiter->count);
+    return NULL;
+}
+
+// A registration from another thread wakes a wait that has nothing to report
+static void test_change_wakes_wait()
+{
+    int fds[2];
+    make_pair(fds);
+
+    struct waiter waiter = { 0 };
+    pthread_t thread;
+    pthread_create(&thread, NULL, wait_thread, &waiter);
+
+    // Give the waiter time to block in poll, the test also passes if it didn't
+    usleep(50 * 1000);
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_WRITE, 7) == 0);
+    pthread_join(thread, NULL);
+
+    CHECK(waiter.result == 0 && waiter.count == 1);
+    CHECK(waiter.event.data == 7 && waiter.event.events == SOCKET_EVENT_WRITE);
+
+    // Same for a rearm
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_READ, 8) == 0);
+    CHECK(send(fds[1], "x", 1, 0) == 1);
+    CHECK(events_for(8) == SOCKET_EVENT_READ);
+
+    pthread_create(&thread, NULL, wait_thread, &waiter);
+    usleep(50 * 1000);
+    socket_event_port_rearm(fds[0], SOCKET_EVENT_READ);
+    pthread_join(thread, NULL);
+
+    CHECK(waiter.result == 0 && waiter.count == 1);
+    CHECK(waiter.event.data == 8 && waiter.event.events == SOCKET_EVENT_READ);
+
+    close_pair(fds);
+}
+
+// A socket registered with a second port is only reported there
+static void test_move()
+{
+    struct socket_event_port *other;
+    CHECK(socket_event_port_create(&other) == 0);
+
+    int fds[2];
+    make_pair(fds);
+    CHECK(socket_event_port_change(port, fds[0], SOCKET_EVENT_WRITE, 9) == 0);
+    CHECK(socket_event_port_change(other, fds[0], SOCKET_EVENT_WRITE, 10) == 0);
+    CHECK(events_for(9) == 0);
+
+    struct socket_event event;
+    int32_t count = 1;
+    CHECK(socket_event_port_wait(other, &event, &count) == 0);
+    CHECK(count == 1 && event.data == 10 && event.events == SOCKET_EVENT_WRITE);
+
+    close_pair(fds);
+    socket_event_port_close(other);
+}
+
+// The runtime's sockets are TCP: a listener, a connect that returns EINPROGRESS and the accepted socket over 127.0.0.1
+static void test_tcp_loopback()
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(listener >= 0);
+
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    CHECK(bind(listener, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    CHECK(getsockname(listener, (struct sockaddr *)&addr, &length) == 0);
+    CHECK(listen(listener, 4) == 0);
+    set_nonblocking(listener);
+
+    CHECK(socket_event_port_change(port, listener, SOCKET_EVENT_READ, 11) == 0);
+    CHECK(events_for(11) == 0);
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(client >= 0);
+    set_nonblocking(client);
+    CHECK(connect(client, (struct sockaddr *)&addr, length) == 0 || errno == EINPROGRESS);
+
+    // A pending connection makes the listener readable, once
+    wait_for(11, SOCKET_EVENT_READ);
+    CHECK(events_for(11) == 0);
+
+    int server = accept(listener, NULL, NULL);
+    CHECK(server >= 0);
+    set_nonblocking(server);
+    CHECK(accept(listener, NULL, NULL) < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+    socket_event_port_rearm(listener, SOCKET_EVENT_READ);
+    CHECK(events_for(11) == 0);
+    CHECK(socket_event_port_change(port, listener, 0, 0) == 0);
+
+    // The connect completed, the client is writable and has nothing to read
+    CHECK(socket_event_port_change(port, client, SOCKET_EVENT_READ | SOCKET_EVENT_WRITE, 12) == 0);
+    CHECK(wait_for(12, SOCKET_EVENT_WRITE) == SOCKET_EVENT_WRITE);
+
+    CHECK(send(server, "x", 1, 0) == 1);
+    CHECK(wait_for(12, SOCKET_EVENT_READ) == SOCKET_EVENT_READ);
+    CHECK(events_for(12) == 0);
+
+    drain(client);
+    socket_event_port_rearm(client, SOCKET_EVENT_READ);
+    CHECK(events_for(12) == 0);
+
+    CHECK(send(server, "y", 1, 0) == 1);
+    CHECK(wait_for(12, SOCKET_EVENT_READ) == SOCKET_EVENT_READ);
+
+    // The peer closing makes the client readable again, recv returns 0 for it
+    drain(client);
+    socket_event_port_rearm(client, SOCKET_EVENT_READ);
+    socket_event_port_forget(server);
+    close(server);
+    wait_for(12, SOCKET_EVENT_READ);
+
+    socket_event_port_forget(client);
+    close(client);
+    socket_event_port_forget(listener);
+    close(listener);
+}
+
+int main()
+{
+    // Before the first port there is nothing to look up
+    socket_event_port_rearm(0, SOCKET_EVENT_READ);
+    socket_event_port_forget(0);
+
+    CHECK(socket_event_port_create(&port) == 0);
+    make_pair(sentinel);
+
+    test_one_shot_and_rearm();
+    test_change_reports_again();
+    test_hangup();
+    test_forget();
+    test_change_wakes_wait();
+    test_move();
+    test_tcp_loopback();
+
+    close_pair(sentinel);
+    socket_event_port_close(port);
+    printf("socket_event_port: ok\n");
+    return 0;
+}